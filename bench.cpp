@@ -0,0 +1,386 @@
+/**
+ * @file bench.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Microbenchmarks of the board's hot paths on a fixed set of deals.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <streambuf>
+#include <vector>
+#include "board.h"
+#include "deal.h"
+#include "notation.h"
+#include "packed_board.h"
+#include "renderer.h"
+#include "solitaire.h"
+#include "stats.h"
+
+using namespace std;
+using namespace solitaire;
+
+#ifdef SOLITAIRE_STATS
+/**
+ * Returns the number of allocations made so far by this thread, which the
+ * stats count.
+ */
+static uint64_t NumAllocs() {
+  return ThreadStats().counts[static_cast<int>(Counter::ALLOCATIONS)];
+}
+#else
+/**
+ * The number of allocations made so far, counted by operator new.
+ */
+static uint64_t numAllocs = 0;
+
+static uint64_t NumAllocs() {
+  return numAllocs;
+}
+
+void* operator new(size_t size) {
+  numAllocs++;
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+#endif
+
+/**
+ * The deals every benchmark runs on: deals 0 up to kCorpusSize.
+ */
+static const int kCorpusSize = 1000;
+
+/**
+ * The number of times each benchmark runs over its positions.
+ */
+static const int kRounds = 20;
+
+/**
+ * The most positions kept for each kind of move.
+ */
+static const int kMaxSamples = 4000;
+
+/**
+ * The number of new talons dealt in a row from each deal.
+ */
+static const int kNewTalonsPerDeal = 50;
+
+/**
+ * Bench accumulates the time and allocations of the timed parts of one
+ * benchmark and prints them as a line of tab-separated fields: the name, the
+ * nanoseconds per operation, the allocations per operation and the number of
+ * operations timed.
+ */
+class Bench {
+private:
+  const char* name;
+  chrono::steady_clock::time_point start;
+  uint64_t allocsAtStart;
+  chrono::steady_clock::duration elapsed;
+  uint64_t allocs;
+  uint64_t ops;
+
+public:
+  explicit Bench(const char* name)
+    : name(name), allocsAtStart(0), elapsed(0), allocs(0), ops(0) { }
+
+  void Start() {
+    allocsAtStart = NumAllocs();
+    start = chrono::steady_clock::now();
+  }
+
+  void Stop(uint64_t numOps) {
+    elapsed += chrono::steady_clock::now() - start;
+    allocs += NumAllocs() - allocsAtStart;
+    ops += numOps;
+  }
+
+  ~Bench() {
+    double ns = chrono::duration<double, nano>(elapsed).count();
+    cout << name << "\t" << ns / ops << "\t" << double(allocs) / ops << "\t"
+         << ops << endl;
+  }
+};
+
+/**
+ * A stream buffer that throws away everything written to it.
+ */
+class NullBuffer : public streambuf {
+protected:
+  int overflow(int c) override {
+    return c;
+  }
+
+  streamsize xsputn(const char*, streamsize count) override {
+    return count;
+  }
+};
+
+/**
+ * A position from the corpus and a legal move from it.
+ */
+struct Sample {
+  PackedBoard position;
+  Move move;
+};
+
+/**
+ * Walks each deal of the corpus with random legal moves and keeps up to
+ * kMaxSamples positions for each kind of move, with a move of that kind.
+ */
+static vector<vector<Sample>> CollectSamples(int numOpenCards) {
+  const int kNumTypes = static_cast<int>(Move::Type::TABLEAU_TO_TABLEAU) + 1;
+  const int kMovesPerDeal = 200;
+  vector<vector<Sample>> samples(kNumTypes);
+  PackedBoard board;
+  MoveBuffer moves;
+  for (int deal = 0; deal < kCorpusSize; deal++) {
+    board.Deal(deal, numOpenCards);
+    SplitMix64 random(deal);
+    for (int i = 0; i < kMovesPerDeal && !board.IsWon(); i++) {
+      board.GenerateMoves(moves);
+      if (moves.Empty()) {
+        break;
+      }
+      for (int j = 0; j < moves.Size(); j++) {
+        vector<Sample>& kind = samples[static_cast<int>(moves[j].type)];
+        if (kind.size() < size_t(kMaxSamples)) {
+          kind.push_back({ board, moves[j] });
+        }
+      }
+      board.ApplyMove(moves[random.Below(moves.Size())]);
+    }
+  }
+  return samples;
+}
+
+/**
+ * Times one of the Board::Do* methods on every sampled position with a move
+ * of its kind.
+ */
+static void BenchMove(const char* name, const vector<Sample>& samples,
+                      const function<bool(Board&, Move)>& doMove) {
+  Bench bench(name);
+  vector<Board> boards;
+  for (int round = 0; round < kRounds; round++) {
+    boards.clear();
+    for (const Sample& sample : samples) {
+      boards.emplace_back(sample.position);
+    }
+    bench.Start();
+    for (size_t i = 0; i < boards.size(); i++) {
+      doMove(boards[i], samples[i].move);
+    }
+    bench.Stop(boards.size());
+  }
+}
+
+int main() {
+  vector<vector<Sample>> samples = CollectSamples(kThreeCardGame);
+  vector<Board> positions;
+  vector<PackedBoard> packedPositions;
+  for (const vector<Sample>& kind : samples) {
+    for (const Sample& sample : kind) {
+      positions.emplace_back(sample.position);
+      packedPositions.push_back(sample.position);
+    }
+  }
+
+  cout << "benchmark\tns/op\tallocs/op\tops" << endl;
+
+  {
+    Bench bench("Board::Reset");
+    Board board;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (int deal = 0; deal < kCorpusSize; deal++) {
+        board.Reset(kThreeCardGame, deal);
+      }
+      bench.Stop(kCorpusSize);
+    }
+  }
+
+  BenchMove("Board::DoMoveTalonToFoundation",
+            samples[static_cast<int>(Move::Type::TALON_TO_FOUNDATION)],
+            [](Board& board, Move) {
+              return board.DoMoveTalonToFoundation();
+            });
+  BenchMove("Board::DoMoveTableauToFoundation",
+            samples[static_cast<int>(Move::Type::TABLEAU_TO_FOUNDATION)],
+            [](Board& board, Move move) {
+              return board.DoMoveTableauToFoundation(move.from);
+            });
+  BenchMove("Board::DoMoveTalonToTableau",
+            samples[static_cast<int>(Move::Type::TALON_TO_TABLEAU)],
+            [](Board& board, Move move) {
+              return board.DoMoveTalonToTableau(move.to);
+            });
+  BenchMove("Board::DoMoveFoundationToTableau",
+            samples[static_cast<int>(Move::Type::FOUNDATION_TO_TABLEAU)],
+            [](Board& board, Move move) {
+              return board.DoMoveFoundationToTableau(move.from, move.to);
+            });
+  BenchMove("Board::DoMoveTableauToTableau",
+            samples[static_cast<int>(Move::Type::TABLEAU_TO_TABLEAU)],
+            [](Board& board, Move move) {
+              return board.DoMoveTableauToTableau(move.from, move.to);
+            });
+
+  const int kDrawCounts[] = { kOneCardGame, kThreeCardGame };
+  for (int numOpenCards : kDrawCounts) {
+    Bench bench(numOpenCards == kOneCardGame ? "Board::DoNewTalon/draw-1"
+                : "Board::DoNewTalon/draw-3");
+    vector<Board> boards;
+    for (int deal = 0; deal < kCorpusSize; deal++) {
+      boards.emplace_back(deal, numOpenCards);
+    }
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (Board& board : boards) {
+        for (int i = 0; i < kNewTalonsPerDeal; i++) {
+          board.DoNewTalon();
+        }
+      }
+      bench.Stop(boards.size() * kNewTalonsPerDeal);
+    }
+  }
+
+  {
+    Bench bench("Board::ValidMovesInFrame");
+    int found = 0;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const Board& board : positions) {
+        found += board.ValidMovesInFrame();
+      }
+      bench.Stop(positions.size());
+    }
+    if (found < 0) {
+      cerr << found << endl;
+    }
+  }
+
+  {
+    Bench bench("Board::GenerateMoves");
+    MoveBuffer moves;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const Board& board : positions) {
+        board.GenerateMoves(moves);
+      }
+      bench.Stop(positions.size());
+    }
+  }
+
+  {
+    Bench bench("PackedBoard::GenerateMoves");
+    MoveBuffer moves;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const PackedBoard& board : packedPositions) {
+        board.GenerateMoves(moves);
+      }
+      bench.Stop(packedPositions.size());
+    }
+  }
+
+  {
+    Bench bench("Board::DrawBoard");
+    NullBuffer buffer;
+    ostream null(&buffer);
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const Board& board : positions) {
+        board.DrawBoard(null);
+      }
+      bench.Stop(positions.size());
+    }
+  }
+
+  {
+    Bench bench("Card::Print");
+    NullBuffer buffer;
+    ostream null(&buffer);
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (int deal = 0; deal < kCorpusSize; deal++) {
+        for (CardCode code = 0; code < kDeckSize; code++) {
+          CardOf(code).Print(null);
+        }
+      }
+      bench.Stop(kCorpusSize * kDeckSize);
+    }
+  }
+
+  {
+    Bench bench("FormatPosition");
+    char text[kMaxPositionTextSize];
+    size_t length = 0;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const PackedBoard& board : packedPositions) {
+        length += FormatPosition(board, text) - text;
+      }
+      bench.Stop(packedPositions.size());
+    }
+    if (length == 0) {
+      cerr << length << endl;
+    }
+  }
+
+  {
+    Bench bench("ParsePosition");
+    vector<char> texts;
+    vector<size_t> ends;
+    for (const PackedBoard& board : packedPositions) {
+      char text[kMaxPositionTextSize];
+      texts.insert(texts.end(), text, FormatPosition(board, text));
+      ends.push_back(texts.size());
+    }
+    PackedBoard board;
+    int parsed = 0;
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      size_t begin = 0;
+      for (size_t end : ends) {
+        parsed += ParsePosition(string_view(&texts[begin], end - begin), board);
+        begin = end;
+      }
+      bench.Stop(ends.size());
+    }
+    if (parsed == 0) {
+      cerr << parsed << endl;
+    }
+  }
+
+  const Renderer::Mode kModes[] = { Renderer::Mode::PLAIN,
+                                    Renderer::Mode::ANSI };
+  for (Renderer::Mode mode : kModes) {
+    Bench bench(mode == Renderer::Mode::PLAIN ? "Renderer::Draw/plain"
+                : "Renderer::Draw/ansi");
+    NullBuffer buffer;
+    ostream null(&buffer);
+    Renderer renderer(mode);
+    for (int round = 0; round < kRounds; round++) {
+      bench.Start();
+      for (const Board& board : positions) {
+        renderer.Draw(board, null);
+      }
+      bench.Stop(positions.size());
+    }
+  }
+  return 0;
+}
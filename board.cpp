@@ -5,11 +5,12 @@
  * @brief A Solitaire board
  */
 #include <algorithm>
-#include <cstdlib>
-#include <ctime>
-#include <iomanip>
 #include <string>
 #include "board.h"
+#include "deal.h"
+#include "packed_board.h"
+#include "stats.h"
+#include "zobrist.h"
 
 namespace solitaire {
   using namespace std;
@@ -45,10 +46,18 @@ namespace solitaire {
     return pile.back();
   }
 
+  const Card& CardPile::Last() const {
+    return pile.back();
+  }
+
   CardPile::Pile::const_iterator CardPile::Begin() const {
     return pile.begin();
   }
 
+  CardPile::Pile::iterator CardPile::Begin() {
+    return pile.begin();
+  }
+
   CardPile::Pile::const_iterator CardPile::End() const {
     return pile.end();
   }
@@ -65,6 +74,10 @@ namespace solitaire {
     return pile.empty();
   }
 
+  int CardPile::Size() const {
+    return pile.size();
+  }
+
   bool TableauPile::AllShown() const {
     return shown == Begin();
   }
@@ -77,80 +90,159 @@ namespace solitaire {
     return shown;
   }
 
+  void TableauPile::SetShown(Pile::iterator position) {
+    shown = position;
+    cshown = position;
+  }
+
+  template <class InputIterator>
+  void TableauPile::Append(InputIterator first, InputIterator last) {
+    bool wasEmpty = Empty();
+    Insert(End(), first, last);
+    if (wasEmpty) {
+      SetShown(Begin());
+    }
+  }
+
+  void TableauPile::EraseFrom(Pile::iterator position) {
+    bool turnOver = position == shown;
+    Erase(position, End());
+    if (turnOver) {
+      SetShown(Empty() ? End() : prev(End()));
+    }
+  }
+
   Suit SuitPile::GetSuit() const {
     return suit;
   }
 
-  Board::Board(int numOpenCards) {
+  Board::Board(int numOpenCards) : autoPlay(false) {
     Reset(numOpenCards);
   }
 
+  Board::Board(uint64_t dealNumber, int numOpenCards) : autoPlay(false) {
+    Reset(numOpenCards, dealNumber);
+  }
+
   void Board::Reset(int numOpenCards) {
-    this->numOpenCards = numOpenCards;
-    status = Status::PLAYING;
-    stuckState = nullptr;
+    Reset(numOpenCards, RandomDealNumber());
+  }
+
+  void Board::Reset(int numOpenCards, uint64_t dealNumber) {
+    PackedBoard packed;
+    packed.Deal(dealNumber, numOpenCards);
+    Unpack(packed);
+    if (autoPlay) {
+      PlaySafeMoves();
+    }
+  }
+
+  Board::Board(const PackedBoard& packed) : autoPlay(false) {
+    Unpack(packed);
+  }
+
+  Board::Board(const Board& other) : autoPlay(false) {
+    *this = other;
+  }
+
+  Board& Board::operator=(const Board& other) {
+    if (this != &other) {
+      Unpack(other.Pack());
+      history = other.history;
+      undone = other.undone;
+      autoPlay = other.autoPlay;
+    }
+    return *this;
+  }
+
+  PackedBoard Board::Pack() const {
+    PackedBoard packed;
+    packed.hash = hash;
+    packed.numOpenCards = numOpenCards;
+    packed.status = static_cast<uint8_t>(status);
+
+    packed.deckSize = 0;
+    for (Card card : deck) {
+      packed.deck[packed.deckSize++] = CodeOf(card);
+    }
+    fill(packed.deck + packed.deckSize, packed.deck + kMaxDeckSize, kNoCard);
+    packed.stock = stock;
+    packed.talon = talon;
+    packed.numFaceDown = numFaceDown;
+
+    for (int i = 0; i < kNumSuits; i++) {
+      packed.foundation[i] = foundation[i].Empty()
+        ? kNoCard : CodeOf(*prev(foundation[i].End()));
+    }
+
+    for (int i = 0; i < kTableauSize; i++) {
+      const TableauPile& pile = tableau[i];
+      uint8_t size = 0;
+      for (CardPile::Pile::const_iterator it = pile.Begin(); it != pile.End();
+           ++it) {
+        packed.tableau[i][size++] = CodeOf(*it);
+      }
+      fill(packed.tableau[i] + size, packed.tableau[i] + kMaxTableauPileSize,
+           kNoCard);
+      packed.tableauSize[i] = size;
+      packed.tableauShown[i] = distance(pile.Begin(), pile.ShownBegin());
+    }
+    packed.symmetricDelta = packed.ComputeSymmetricHash() ^ hash;
+    return packed;
+  }
+
+  void Board::Unpack(const PackedBoard& packed) {
+    numOpenCards = packed.numOpenCards;
+
+    deck.clear();
+    for (int i = 0; i < packed.deckSize; i++) {
+      deck.push_back(CardOf(packed.deck[i]));
+    }
+    stock = packed.stock;
+    talon = packed.talon;
+
     foundation = vector<SuitPile>(kNumSuits);
-    tableau = vector<TableauPile>(kTableauSize);
+    for (int i = 0; i < kNumSuits; i++) {
+      if (packed.foundation[i] == kNoCard) {
+        continue;
+      }
+      Card top = CardOf(packed.foundation[i]);
+      foundation[i].suit = top.GetSuit();
+      for (int rank = IntOf(Rank::_A); rank <= IntOf(top.GetRank()); rank++) {
+        foundation[i].PushBack(Card(static_cast<Rank>(rank), top.GetSuit()));
+      }
+    }
 
-    // Creates a vector of all the cards in a deck
-    vector<Card> all = {
-      Card(Rank::_A, Suit::SPADES), Card(Rank::_2, Suit::SPADES),
-      Card(Rank::_3, Suit::SPADES), Card(Rank::_4, Suit::SPADES),
-      Card(Rank::_5, Suit::SPADES), Card(Rank::_6, Suit::SPADES),
-      Card(Rank::_7, Suit::SPADES), Card(Rank::_8, Suit::SPADES),
-      Card(Rank::_9, Suit::SPADES), Card(Rank::_10, Suit::SPADES),
-      Card(Rank::_J, Suit::SPADES), Card(Rank::_Q, Suit::SPADES),
-      Card(Rank::_K, Suit::SPADES), Card(Rank::_A, Suit::HEARTS),
-      Card(Rank::_2, Suit::HEARTS), Card(Rank::_3, Suit::HEARTS),
-      Card(Rank::_4, Suit::HEARTS), Card(Rank::_5, Suit::HEARTS),
-      Card(Rank::_6, Suit::HEARTS), Card(Rank::_7, Suit::HEARTS),
-      Card(Rank::_8, Suit::HEARTS), Card(Rank::_9, Suit::HEARTS),
-      Card(Rank::_10, Suit::HEARTS), Card(Rank::_J, Suit::HEARTS),
-      Card(Rank::_Q, Suit::HEARTS), Card(Rank::_K, Suit::HEARTS),
-      Card(Rank::_A, Suit::CLUBS), Card(Rank::_2, Suit::CLUBS),
-      Card(Rank::_3, Suit::CLUBS), Card(Rank::_4, Suit::CLUBS),
-      Card(Rank::_5, Suit::CLUBS), Card(Rank::_6, Suit::CLUBS),
-      Card(Rank::_7, Suit::CLUBS), Card(Rank::_8, Suit::CLUBS),
-      Card(Rank::_9, Suit::CLUBS), Card(Rank::_10, Suit::CLUBS),
-      Card(Rank::_J, Suit::CLUBS), Card(Rank::_Q, Suit::CLUBS),
-      Card(Rank::_K, Suit::CLUBS), Card(Rank::_A, Suit::DIAMONDS),
-      Card(Rank::_2, Suit::DIAMONDS), Card(Rank::_3, Suit::DIAMONDS),
-      Card(Rank::_4, Suit::DIAMONDS), Card(Rank::_5, Suit::DIAMONDS),
-      Card(Rank::_6, Suit::DIAMONDS), Card(Rank::_7, Suit::DIAMONDS),
-      Card(Rank::_8, Suit::DIAMONDS), Card(Rank::_9, Suit::DIAMONDS),
-      Card(Rank::_10, Suit::DIAMONDS), Card(Rank::_J, Suit::DIAMONDS),
-      Card(Rank::_Q, Suit::DIAMONDS), Card(Rank::_K, Suit::DIAMONDS) };
-
-    // Creates a random shuffle to begin a new game
-    srand(time(nullptr));
-    random_shuffle(all.begin(), all.end(), [](int i) -> int
-                   { return rand() % i; });
-
-    // make the tableau
-    vector<Card>::iterator it = all.begin();
+    tableau = vector<TableauPile>(kTableauSize);
+    numFaceDown = 0;
     for (int i = 0; i < kTableauSize; i++) {
-      tableau[i] = TableauPile(it, next(it, i + 1));
-      tableau[i].shown = prev(tableau[i].End());
-      tableau[i].cshown = prev(tableau[i].End());
-      advance(it, i + 1);
+      TableauPile& pile = tableau[i];
+      for (int j = 0; j < packed.tableauSize[i]; j++) {
+        pile.PushBack(CardOf(packed.tableau[i][j]));
+      }
+      pile.SetShown(next(pile.Begin(), packed.tableauShown[i]));
+      numFaceDown += packed.tableauShown[i];
     }
+    hash = packed.ComputeHash();
+    history.clear();
+    undone.clear();
+    RefreshAllCards();
 
-    // make the stock cards
-    deck = CardPile::Pile(it, all.end());
-    stock = deck.begin();
-    talon = deck.end();
+    // the status follows from the position, whatever the packed one says
+    status = Status::PLAYING;
+    UpdateStatus();
   }
 
   bool Board::TalonEmpty() const {
-    return talon == deck.end();
+    return talon == int(deck.size());
   }
 
   bool Board::StockEmpty() const {
-    return stock == deck.end();
+    return stock == int(deck.size());
   }
 
   bool Board::DeckEmpty() const {
-    return deck.begin() == deck.end();
+    return deck.empty();
   }
 
   Board::operator bool() const {
@@ -158,41 +250,154 @@ namespace solitaire {
   }
 
   void Board::UpdateStatus() {
-    if (ValidMovesInFrame()) { // valid moves exist...
-      stuckState = nullptr;
+    if (CanAutoComplete()) {
+      status = Status::WON;
       return;
     }
 
-    // no valid moves...
-    if (stuckState == nullptr) { // there were moves in prior frames but not now
-      stuckState = &talon;
-    } else {                     // no moves in prior frames through now
-      if (*stuckState == talon) {
-        status = Status::STUCK;
+    if (!HasReachableMove()) {
+      status = Status::STUCK;
+    }
+  }
+
+  /**
+   * Returns the mask of the card.
+   */
+  static inline uint64_t MaskOf(Card card) {
+    return uint64_t(1) << CodeOf(card);
+  }
+
+  /**
+   * The mask of every card of the rank.
+   */
+  static inline uint64_t RankMask(Rank rank) {
+    uint64_t mask = 0;
+    for (int suit = 0; suit < kNumSuits; suit++) {
+      mask |= MaskOf(Card(rank, static_cast<Suit>(suit)));
+    }
+    return mask;
+  }
+
+  void Board::RefreshTableauCards(Tableau::size_type tableauIdx) {
+    const TableauPile& pile = tableau[tableauIdx];
+    uint64_t accepts = 0;
+    uint64_t shown = 0;
+    if (pile.Empty()) {
+      accepts = RankMask(Rank::_K);
+    } else {
+      // the cards one rank lower in the suits of the other color
+      Card last = pile.Last();
+      if (!last.IsAce()) {
+        Rank lower = static_cast<Rank>(IntOf(last.GetRank()) - 1);
+        for (int suit = 0; suit < kNumSuits; suit++) {
+          Card card(lower, static_cast<Suit>(suit));
+          if (card.SuitOppositeColorFrom(last)) {
+            accepts |= MaskOf(card);
+          }
+        }
+      }
+      for (CardPile::Pile::const_iterator it = pile.ShownBegin();
+           it != pile.End(); ++it) {
+        shown |= MaskOf(*it);
       }
     }
+    tableauAccepts[tableauIdx] = accepts;
+    tableauShownCards[tableauIdx] = shown;
+  }
 
-    if (all_of(tableau.begin(), tableau.end(),
-               [](TableauPile tp) { return tp.Empty(); })) {
-      status = Status::WON;
+  void Board::RefreshTalonReach() {
+    // Dealing new talons goes on from the stock to the end of the deck, taking
+    // numOpenCards at a time, and then starts over from the beginning. The
+    // talon card is the last card taken: every numOpenCards-th card from the
+    // beginning and the last card of the deck, and in the current pass the
+    // card under the stock and every numOpenCards-th card after it.
+    deckReach = 0;
+    passReach = 0;
+    int size = deck.size();
+    for (int i = 0; i < size; i++) {
+      if ((i + 1) % numOpenCards == 0 || i == size - 1) {
+        deckReach |= MaskOf(deck[i]);
+      } else if (i + 1 >= stock && (i + 1 - stock) % numOpenCards == 0
+                 && (i + 1 > stock || !TalonEmpty())) {
+        passReach |= MaskOf(deck[i]);
+      }
     }
   }
 
-  Board::Status Board::GetStatus() const {
-    return status;
+  void Board::RefreshCards(Move move) {
+    switch (move.type) {
+    case Move::Type::NEW_TALON: // DoNewTalon and Undo keep their own
+      break;
+    case Move::Type::TALON_TO_FOUNDATION:
+      RefreshTalonReach();
+      break;
+    case Move::Type::TABLEAU_TO_FOUNDATION:
+      RefreshTableauCards(move.from);
+      break;
+    case Move::Type::TALON_TO_TABLEAU:
+      RefreshTableauCards(move.to);
+      RefreshTalonReach();
+      break;
+    case Move::Type::FOUNDATION_TO_TABLEAU:
+      RefreshTableauCards(move.to);
+      break;
+    case Move::Type::TABLEAU_TO_TABLEAU:
+      RefreshTableauCards(move.from);
+      RefreshTableauCards(move.to);
+      break;
+    }
   }
 
-  template <class iterator>
-  static void SafeAdvance(iterator& it, iterator end, size_t delta) {
-    while (it != end && delta--) {
-      ++it;
+  void Board::RefreshAllCards() {
+    for (Tableau::size_type i = 0; i < tableau.size(); i++) {
+      RefreshTableauCards(i);
+    }
+    RefreshTalonReach();
+  }
+
+  bool Board::HasReachableMove() const {
+    // the cards the foundation takes, and the ones it would give back
+    uint64_t foundationAccepts = 0;
+    uint64_t foundationTops = 0;
+    for (const SuitPile& pile : foundation) {
+      if (pile.Empty()) {
+        foundationAccepts |= RankMask(Rank::_A);
+      } else {
+        foundationTops |= MaskOf(pile.Last());
+        if (!pile.Last().IsKing()) {
+          foundationAccepts |= MaskOf(pile.Last()) << 1;
+        }
+      }
+    }
+
+    uint64_t tableauAccepts = 0;
+    uint64_t tableauLasts = 0;
+    for (Tableau::size_type i = 0; i < tableau.size(); i++) {
+      tableauAccepts |= this->tableauAccepts[i];
+      if (!tableau[i].Empty()) {
+        tableauLasts |= MaskOf(tableau[i].Last());
+      }
+    }
+
+    if ((tableauLasts & foundationAccepts) != 0
+        || ((deckReach | passReach) & (foundationAccepts | tableauAccepts))
+           != 0
+        || (foundationTops & tableauAccepts) != 0) {
+      return true;
+    }
+    for (Tableau::size_type from = 0; from < tableau.size(); from++) {
+      for (Tableau::size_type to = 0; to < tableau.size(); to++) {
+        if (from != to
+            && (tableauShownCards[from] & this->tableauAccepts[to]) != 0) {
+          return true;
+        }
+      }
     }
+    return false;
   }
 
-  template <class iterator>
-  static iterator SafeNext(iterator it, iterator end, size_t delta = 1) {
-    SafeAdvance(it, end, delta);
-    return it;
+  Board::Status Board::GetStatus() const {
+    return status;
   }
 
 
@@ -201,21 +406,33 @@ namespace solitaire {
       return false;
     }
 
-    if (stock == deck.end()) { // reached end of the stock
-      talon = deck.end();
-      stock = deck.begin();
-    } else if (talon == deck.end()) {
-      talon = deck.begin();
-      stock = SafeNext(talon, deck.end(), numOpenCards);
-    } else {                   // keep stock position relative to talon
-      SafeAdvance(talon, deck.end(), numOpenCards);
-      stock = SafeNext(talon, deck.end(), numOpenCards);
+    HashCheck<Board> check(*this);
+    UndoRecord record = StartRecord({ Move::Type::NEW_TALON, 0, 0, 0 });
+    hash ^= CursorHash();
+    if (StockEmpty()) {        // reached end of the stock
+      talon = deck.size();
+      stock = 0;
+      passReach = 0;
+      SOLITAIRE_COUNT(TALON_CYCLES, 1);
+    } else {                   // flip the next cards after the talon
+      if (!TalonEmpty()) {     // the talon card is passed for this pass
+        passReach &= ~MaskOf(GetTalonCard());
+      }
+      talon = stock;
+      stock = min(stock + numOpenCards, int(deck.size()));
+    }
+    hash ^= CursorHash();
+    Played(record);
+
+    UpdateStatus();
+    if (autoPlay) {
+      PlaySafeMoves();
     }
     return true;
   }
 
 
-  void Board::DoGetHint() {
+  void Board::DoGetHint() const {
     cout << endl;
     if (ValidMovesInFrame()) {
       cout << "There is a valid move available!";
@@ -235,7 +452,7 @@ namespace solitaire {
       && kingHigh.SuitOppositeColorFrom(aceLow);
   }
 
-  static inline bool CanBuildDown(Card card, TableauPile tableauPile) {
+  static inline bool CanBuildDown(Card card, const TableauPile& tableauPile) {
     if (tableauPile.Empty() && card.IsKing()) {
       return true;
     }
@@ -253,9 +470,8 @@ namespace solitaire {
     return aceLow.RankOneLessThan(kingHigh) && aceLow.SuitSameAs(kingHigh);
   }
 
-  static inline bool CanBuildUp(Card card, SuitPile suitPile) {
-    if (suitPile.Empty() && suitPile.GetSuit() == card.GetSuit()
-        && card.IsAce()) {
+  static inline bool CanBuildUp(Card card, const SuitPile& suitPile) {
+    if (suitPile.Empty() && card.IsAce()) {
       return true;
     }
     if (!suitPile.Empty() && CanBuildUp(suitPile.Last(), card)) {
@@ -264,22 +480,126 @@ namespace solitaire {
     return false;
   }
 
+  uint64_t Board::CursorHash() const {
+    CardCode talonCard = TalonEmpty() ? kNoCard : CodeOf(GetTalonCard());
+    CardCode talonFirst = TalonEmpty() ? kNoCard : CodeOf(deck[talon]);
+    return CursorKey(talonCard, talonFirst);
+  }
+
+  void Board::EraseTalonCard() {
+    int position = stock - 1;
+    hash ^= CursorHash() ^ DeckKey(CodeOf(deck[position]));
+    if (position == talon) { // the talon was only this card
+      talon = position == 0 ? deck.size() - 1 : position - 1;
+    }
+    deck.erase(deck.begin() + position);
+    stock--;
+    hash ^= CursorHash();
+  }
+
+  void Board::InsertTalonCard(Card card, const UndoRecord& record) {
+    hash ^= CursorHash() ^ DeckKey(CodeOf(card));
+    deck.insert(deck.begin() + record.stock - 1, card);
+    talon = record.talon;
+    stock = record.stock;
+    hash ^= CursorHash();
+  }
+
+  void Board::RestoreCursors(const UndoRecord& record) {
+    hash ^= CursorHash();
+    talon = record.talon;
+    stock = record.stock;
+    hash ^= CursorHash();
+  }
+
+  template <class InputIterator>
+  void Board::AppendToTableau(Tableau::size_type tableauIdx,
+                              InputIterator first, InputIterator last) {
+    TableauPile& tableauPile = tableau[tableauIdx];
+    int index = tableauPile.Size();
+    for (InputIterator it = first; it != last; ++it) {
+      hash ^= TableauKey(tableauIdx, index++, CodeOf(*it));
+    }
+    tableauPile.Append(first, last);
+  }
+
+  bool Board::EraseFromTableau(Tableau::size_type tableauIdx,
+                               CardPile::Pile::iterator position) {
+    TableauPile& tableauPile = tableau[tableauIdx];
+    int first = tableauPile.Size() - distance(position, tableauPile.End());
+    bool turnOver = position == tableauPile.ShownBegin();
+    if (turnOver) { // turns over the card below
+      hash ^= ShownKey(tableauIdx, first)
+        ^ ShownKey(tableauIdx, first == 0 ? 0 : first - 1);
+      numFaceDown -= first == 0 ? 0 : 1;
+    }
+    int index = first;
+    for (CardPile::Pile::iterator it = position; it != tableauPile.End();
+         ++it) {
+      hash ^= TableauKey(tableauIdx, index++, CodeOf(*it));
+    }
+    tableauPile.EraseFrom(position);
+    return turnOver;
+  }
+
+  void Board::ShowFromInTableau(Tableau::size_type tableauIdx,
+                                CardPile::Pile::iterator position) {
+    TableauPile& tableauPile = tableau[tableauIdx];
+    int shown = distance(tableauPile.Begin(), tableauPile.ShownBegin());
+    int first = distance(tableauPile.Begin(), position);
+    hash ^= ShownKey(tableauIdx, shown) ^ ShownKey(tableauIdx, first);
+    numFaceDown += first - shown;
+    tableauPile.SetShown(position);
+  }
+
+  void Board::PushToFoundation(Foundation::size_type foundationIdx,
+                               Card card) {
+    SuitPile& suitPile = foundation[foundationIdx];
+    CardCode top = suitPile.Empty() ? kNoCard : CodeOf(suitPile.Last());
+    hash ^= FoundationKey(foundationIdx, top)
+      ^ FoundationKey(foundationIdx, CodeOf(card));
+    suitPile.suit = card.GetSuit();
+    suitPile.PushBack(card);
+  }
+
+  void Board::PopFromFoundation(Foundation::size_type foundationIdx) {
+    SuitPile& suitPile = foundation[foundationIdx];
+    CardPile::Pile::iterator it = prev(suitPile.End());
+    hash ^= FoundationKey(foundationIdx, CodeOf(*it));
+    suitPile.Erase(it);
+    CardCode top = suitPile.Empty() ? kNoCard : CodeOf(suitPile.Last());
+    hash ^= FoundationKey(foundationIdx, top);
+  }
+
+  uint64_t Board::Hash() const {
+    return hash;
+  }
+
+  uint64_t Board::ComputeHash() const {
+    return Pack().ComputeHash();
+  }
+
   bool Board::DoMoveTalonToFoundation() {
-    Card& talonCard = GetTalonCard();
-    for (SuitPile& suitPile : foundation) {
-      if (CanBuildUp(talonCard, suitPile)) {
-        suitPile.PushBack(talonCard);
-        CardPile::Pile::iterator position = GetTalonCardIterator();
-        if (position == talon) {
-          --talon;
-        }
-        deck.erase(position);
+    if (TalonEmpty()) {
+      return false;
+    }
+    int foundationIdx = FoundationFor(GetTalonCard());
+    if (foundationIdx < 0) {
+      return false;
+    }
 
-        UpdateStatus();
-        return true;
-      }
+    HashCheck<Board> check(*this);
+    UndoRecord record = StartRecord({ Move::Type::TALON_TO_FOUNDATION, 0,
+          uint8_t(foundationIdx), 1 });
+    PushToFoundation(foundationIdx, GetTalonCard());
+    EraseTalonCard();
+    Played(record);
+
+    UpdateStatus();
+    if (autoPlay) {
+      PlaySafeMoves();
     }
-    return false;
+    return true;
   }
 
   bool Board::DoMoveTableauToFoundation(Tableau::size_type tableauIdx) {
@@ -292,45 +612,51 @@ namespace solitaire {
     }
 
     CardPile::Pile::iterator it = prev(tableauPile.End());
-    for (SuitPile& suitPile : foundation) {
-      if (CanBuildUp(*it, suitPile)) {
-        suitPile.PushBack(*it);
-        if (it == tableauPile.ShownBegin()
-            && tableauPile.ShownBegin() != tableauPile.Begin()) {
-          --tableauPile.shown;
-          --tableauPile.cshown;
-        }
-        tableauPile.Erase(it);
+    int foundationIdx = FoundationFor(*it);
+    if (foundationIdx < 0) {
+      return false;
+    }
 
-        UpdateStatus();
-        return true;
-      }
+    HashCheck<Board> check(*this);
+    UndoRecord record = StartRecord({ Move::Type::TABLEAU_TO_FOUNDATION,
+          uint8_t(tableauIdx), uint8_t(foundationIdx), 1 });
+    PushToFoundation(foundationIdx, *it);
+    record.turnedOver = EraseFromTableau(tableauIdx, it);
+    Played(record);
+
+    UpdateStatus();
+    if (autoPlay) {
+      PlaySafeMoves();
     }
-    return false;
+    return true;
   }
 
   bool Board::DoMoveTalonToTableau(Foundation::size_type tableauIdx) {
-    if (tableauIdx >= tableau.size()) {
+    if (tableauIdx >= tableau.size() || TalonEmpty()) {
       return false;
     }
     Card& talonCard = GetTalonCard();
     if (CanBuildDown(talonCard, tableau[tableauIdx])) {
-        tableau[tableauIdx].PushBack(talonCard);
-        CardPile::Pile::iterator position = GetTalonCardIterator();
-        if (position == talon) {
-          --talon;
-        }
-        deck.erase(position);
+      HashCheck<Board> check(*this);
+      UndoRecord record = StartRecord({ Move::Type::TALON_TO_TABLEAU, 0,
+            uint8_t(tableauIdx), 1 });
+      Deck::iterator position = GetTalonCardIterator();
+      AppendToTableau(tableauIdx, position, next(position));
+      EraseTalonCard();
+      Played(record);
 
-        UpdateStatus();
-        return true;
+      UpdateStatus();
+      if (autoPlay) {
+        PlaySafeMoves();
+      }
+      return true;
     }
     return false;
   }
 
   bool Board::DoMoveFoundationToTableau(Foundation::size_type foundationIdx,
                                         Tableau::size_type tableauIdx) {
-    if (foundationIdx >= foundation.size()) {
+    if (foundationIdx >= foundation.size() || tableauIdx >= tableau.size()) {
       return false;
     }
     TableauPile& tableauPile = tableau[tableauIdx];
@@ -340,10 +666,17 @@ namespace solitaire {
     }
     CardPile::Pile::iterator it = --suitPile.End();
     if (CanBuildDown(*it, tableauPile)) {
-      tableauPile.PushBack(*it);
-      suitPile.Erase(it);
+      HashCheck<Board> check(*this);
+      UndoRecord record = StartRecord({ Move::Type::FOUNDATION_TO_TABLEAU,
+            uint8_t(foundationIdx), uint8_t(tableauIdx), 1 });
+      AppendToTableau(tableauIdx, it, next(it));
+      PopFromFoundation(foundationIdx);
+      Played(record);
 
       UpdateStatus();
+      if (autoPlay) {
+        PlaySafeMoves();
+      }
       return true;
     }
     return false;
@@ -356,24 +689,25 @@ namespace solitaire {
       return false;
     }
 
-    TableauPile& fromPile = tableau[fromIdx];
-    TableauPile& toPile = tableau[toIdx];
-    for (CardPile::Pile::iterator it = fromPile.ShownBegin(); it != fromPile.End();
-         ++it) {
-      if (CanBuildDown(*it, toPile)) {
-        toPile.Insert(toPile.End(), it, fromPile.End());
-        if (it == fromPile.ShownBegin()
-            && fromPile.ShownBegin() != fromPile.Begin()) {
-          --fromPile.shown;
-          --fromPile.cshown;
-        }
-        fromPile.Erase(it, fromPile.End());
+    int count = CountToMove(fromIdx, toIdx);
+    if (count == 0) {
+      return false;
+    }
 
-        UpdateStatus();
-        return true;
-      }
+    HashCheck<Board> check(*this);
+    UndoRecord record = StartRecord({ Move::Type::TABLEAU_TO_TABLEAU,
+          uint8_t(fromIdx), uint8_t(toIdx), uint8_t(count) });
+    TableauPile& fromPile = tableau[fromIdx];
+    CardPile::Pile::iterator it = prev(fromPile.End(), count);
+    AppendToTableau(toIdx, it, fromPile.End());
+    record.turnedOver = EraseFromTableau(fromIdx, it);
+    Played(record);
+
+    UpdateStatus();
+    if (autoPlay) {
+      PlaySafeMoves();
     }
-    return false;
+    return true;
   }
 
   Card& Board::GetTalonCard() {
@@ -384,154 +718,408 @@ namespace solitaire {
     return *GetTalonCardIterator();
   }
 
-  CardPile::Pile::const_iterator Board::GetTalonCardIterator() const {
-    return prev(stock);
+  Board::Deck::const_iterator Board::GetTalonCardIterator() const {
+    return deck.begin() + stock - 1;
   }
 
-  CardPile::Pile::iterator Board::GetTalonCardIterator() {
-    return prev(stock);
+  Board::Deck::iterator Board::GetTalonCardIterator() {
+    return deck.begin() + stock - 1;
   }
 
-  bool Board::ValidMovesInFrame() const {
-    // possibile moves to the foundation...
-    for (SuitPile suitPile : foundation) {
-      // ...from the tableau
-      for (CardPile tableauPile : tableau) {
-        if (!tableauPile.Empty() &&  CanBuildUp(tableauPile.Last(), suitPile)) {
-          return true;
-        }
+  int Board::NewTalonsToReach(Card card) const {
+    if (!TalonEmpty() && CodeOf(GetTalonCard()) == CodeOf(card)) {
+      return 0;
+    }
+    if (((deckReach | passReach) & MaskOf(card)) == 0) {
+      return -1;
+    }
+    int index = find_if(deck.begin(), deck.end(), [card](Card other) {
+        return CodeOf(other) == CodeOf(card);
+      }) - deck.begin();
+    return solitaire::NewTalonsToReach(index, deck.size(), talon, stock,
+                                       numOpenCards);
+  }
 
-        // ... from the talon
-        if (!TalonEmpty() && CanBuildUp(GetTalonCard(), suitPile)) {
-          return true;
-        }
+  /**
+   * Returns true if the card can go to the foundation with nothing lost: it
+   * is an ace or a two, or the foundation holds both cards of the other color
+   * one rank lower, given the number of cards of each suit on it.
+   */
+  static inline bool SafeToFoundation(Card card,
+                                      const int homeCounts[kNumSuits]) {
+    int rank = IntOf(card.GetRank());
+    int suit = IntOf(card.GetSuit());
+    // the suits alternate in color, so the neighbours are of the other one
+    return rank <= 2 || (homeCounts[(suit + 1) % kNumSuits] >= rank - 1
+                         && homeCounts[(suit + 3) % kNumSuits] >= rank - 1);
+  }
+
+  bool Board::FindSafeMove(Move& move) const {
+    int homeCounts[kNumSuits] = { };
+    for (const SuitPile& suitPile : foundation) {
+      if (!suitPile.Empty()) {
+        homeCounts[IntOf(suitPile.GetSuit())] = suitPile.Size();
+      }
+    }
+
+    if (!TalonEmpty()) {
+      int foundationIdx = FoundationFor(GetTalonCard());
+      if (foundationIdx >= 0
+          && SafeToFoundation(GetTalonCard(), homeCounts)) {
+        move = { Move::Type::TALON_TO_FOUNDATION, 0, uint8_t(foundationIdx),
+                 1 };
+        return true;
+      }
+    }
+    for (Tableau::size_type i = 0; i < tableau.size(); i++) {
+      if (tableau[i].Empty()) {
+        continue;
+      }
+      int foundationIdx = FoundationFor(tableau[i].Last());
+      if (foundationIdx >= 0
+          && SafeToFoundation(tableau[i].Last(), homeCounts)) {
+        move = { Move::Type::TABLEAU_TO_FOUNDATION, uint8_t(i),
+                 uint8_t(foundationIdx), 1 };
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Board::PlaySafeMoves() {
+    // the moves played here would each start this again
+    autoPlay = false;
+    Move move;
+    while (FindSafeMove(move)) {
+      ApplyMove(move);
+    }
+    autoPlay = true;
+  }
+
+  bool Board::CanAutoComplete() const {
+    return numFaceDown == 0 && (numOpenCards == 1 || deck.size() <= 1);
+  }
+
+  bool Board::AutoComplete() {
+    if (!CanAutoComplete()) {
+      return false;
+    }
+    vector<Move> moves;
+    if (!Pack().AutoComplete(moves)) {
+      return false;
+    }
+    // auto-play would play moves of the list out of turn
+    bool wasAutoPlay = autoPlay;
+    autoPlay = false;
+    for (Move move : moves) {
+      ApplyMove(move);
+    }
+    autoPlay = wasAutoPlay;
+    return true;
+  }
+
+  void Board::SetAutoPlay(bool autoPlay) {
+    this->autoPlay = autoPlay;
+    if (autoPlay) {
+      PlaySafeMoves();
+    }
+  }
 
+  bool Board::GetAutoPlay() const {
+    return autoPlay;
+  }
+
+  int Board::FoundationFor(Card card) const {
+    for (Foundation::size_type i = 0; i < foundation.size(); i++) {
+      if (CanBuildUp(card, foundation[i])) {
+        return i;
       }
     }
+    return -1;
+  }
+
+  int Board::CountToMove(Tableau::size_type fromIdx,
+                         Tableau::size_type toIdx) const {
+    const TableauPile& fromPile = tableau[fromIdx];
+    int count = distance(fromPile.ShownBegin(), fromPile.End());
+    for (CardPile::Pile::const_iterator it = fromPile.ShownBegin();
+         it != fromPile.End(); ++it, --count) {
+      if (CanBuildDown(*it, tableau[toIdx])) {
+        return count;
+      }
+    }
+    return 0;
+  }
 
-    // possible moves to the tableau...
-    for (CardPile tableauPile : tableau) {
-      // ...from the tableau
-      for (CardPile fromPile : tableau) {
-        if (&tableauPile == &fromPile) {
+  void Board::GenerateMoves(MoveBuffer& moves) const {
+    moves.Clear();
+
+    // moves to the foundation...
+    if (!TalonEmpty()) {
+      int foundationIdx = FoundationFor(GetTalonCard());
+      if (foundationIdx >= 0) {
+        moves.PushBack({ Move::Type::TALON_TO_FOUNDATION, 0,
+              uint8_t(foundationIdx), 1 });
+      }
+    }
+    for (Tableau::size_type i = 0; i < tableau.size(); i++) {
+      if (tableau[i].Empty()) {
+        continue;
+      }
+      int foundationIdx = FoundationFor(tableau[i].Last());
+      if (foundationIdx >= 0) {
+        moves.PushBack({ Move::Type::TABLEAU_TO_FOUNDATION, uint8_t(i),
+              uint8_t(foundationIdx), 1 });
+      }
+    }
+
+    // moves to the tableau...
+    for (Tableau::size_type to = 0; to < tableau.size(); to++) {
+      for (Tableau::size_type from = 0; from < tableau.size(); from++) {
+        if (from == to) {
           continue;
         }
-        if (tableauPile.Empty() && fromPile.Last().IsKing()) {
-          return true;
-        } else {
-          if (!tableauPile.Empty()
-              && CanBuildDown(tableauPile.Last(), fromPile.Last())) {
-            return true;
-          }
+        int count = CountToMove(from, to);
+        if (count > 0) {
+          moves.PushBack({ Move::Type::TABLEAU_TO_TABLEAU, uint8_t(from),
+                uint8_t(to), uint8_t(count) });
         }
       }
-
-      // ...from the foundation
-      for (CardPile suitPile : foundation) {
-        if (suitPile.Empty()) {
-          continue;
+    }
+    if (!TalonEmpty()) {
+      for (Tableau::size_type to = 0; to < tableau.size(); to++) {
+        if (CanBuildDown(GetTalonCard(), tableau[to])) {
+          moves.PushBack({ Move::Type::TALON_TO_TABLEAU, 0, uint8_t(to), 1 });
         }
-        if (tableauPile.Empty() && suitPile.Last().IsKing()) {
-          return true;
-        } else {
-          if (!tableauPile.Empty()
-              && CanBuildDown(tableauPile.Last(), suitPile.Last())) {
-            return true;
-          }
+      }
+    }
+    for (Foundation::size_type from = 0; from < foundation.size(); from++) {
+      if (foundation[from].Empty()) {
+        continue;
+      }
+      for (Tableau::size_type to = 0; to < tableau.size(); to++) {
+        if (CanBuildDown(foundation[from].Last(), tableau[to])) {
+          moves.PushBack({ Move::Type::FOUNDATION_TO_TABLEAU, uint8_t(from),
+                uint8_t(to), 1 });
         }
       }
+    }
 
-      // ...from the talon
-      if (!TalonEmpty()) {
-        if (tableauPile.Empty() && (*talon).IsKing()) {
-          return true;
-        } else {
-          if (!tableauPile.Empty()
-              && CanBuildDown(tableauPile.Last(), *talon)) {
-            return true;
-          }
+    if (!DeckEmpty()) {
+      moves.PushBack({ Move::Type::NEW_TALON, 0, 0, 0 });
+    }
+  }
+
+  bool Board::ApplyMove(Move move) {
+    switch (move.type) {
+    case Move::Type::NEW_TALON:
+      // a macro move deals count new talons at once
+      for (int i = 0; i < max(int(move.count), 1); i++) {
+        if (!DoNewTalon()) {
+          return false;
         }
       }
+      return true;
+    case Move::Type::TALON_TO_FOUNDATION:
+      return DoMoveTalonToFoundation();
+    case Move::Type::TABLEAU_TO_FOUNDATION:
+      return DoMoveTableauToFoundation(move.from);
+    case Move::Type::TALON_TO_TABLEAU:
+      return DoMoveTalonToTableau(move.to);
+    case Move::Type::FOUNDATION_TO_TABLEAU:
+      return DoMoveFoundationToTableau(move.from, move.to);
+    case Move::Type::TABLEAU_TO_TABLEAU:
+      return DoMoveTableauToTableau(move.from, move.to);
+    default:
+      return false;
     }
+  }
 
-    return false;
+  UndoRecord Board::StartRecord(Move move) const {
+    UndoRecord record;
+    record.move = move;
+    record.turnedOver = false;
+    record.talon = talon;
+    record.stock = stock;
+    record.status = static_cast<uint8_t>(status);
+    return record;
+  }
+
+  void Board::Played(const UndoRecord& record) {
+    SOLITAIRE_COUNT_MOVE(record.move.type, 1);
+    history.push_back(record);
+    undone.clear();
+    RefreshCards(record.move);
+  }
+
+  bool Board::Undo() {
+    if (history.empty()) {
+      return false;
+    }
+    UndoRecord record = history.back();
+    history.pop_back();
+
+    HashCheck<Board> check(*this);
+    const Move& move = record.move;
+    switch (move.type) {
+    case Move::Type::NEW_TALON:
+      RestoreCursors(record);
+      RefreshTalonReach();
+      break;
+
+    case Move::Type::TALON_TO_FOUNDATION: {
+      Card card = foundation[move.to].Last();
+      PopFromFoundation(move.to);
+      InsertTalonCard(card, record);
+      break;
+    }
+    case Move::Type::TABLEAU_TO_FOUNDATION: {
+      Card card = foundation[move.to].Last();
+      PopFromFoundation(move.to);
+      AppendToTableau(move.from, &card, &card + 1);
+      if (record.turnedOver) {
+        ShowFromInTableau(move.from, prev(tableau[move.from].End()));
+      }
+      break;
+    }
+    case Move::Type::TALON_TO_TABLEAU: {
+      Card card = tableau[move.to].Last();
+      EraseFromTableau(move.to, prev(tableau[move.to].End()));
+      InsertTalonCard(card, record);
+      break;
+    }
+    case Move::Type::FOUNDATION_TO_TABLEAU: {
+      Card card = tableau[move.to].Last();
+      EraseFromTableau(move.to, prev(tableau[move.to].End()));
+      PushToFoundation(move.from, card);
+      break;
+    }
+    case Move::Type::TABLEAU_TO_TABLEAU: {
+      TableauPile& fromPile = tableau[move.from];
+      TableauPile& toPile = tableau[move.to];
+      int fromSize = fromPile.Size();
+      CardPile::Pile::iterator it = prev(toPile.End(), move.count);
+      AppendToTableau(move.from, it, toPile.End());
+      EraseFromTableau(move.to, it);
+      if (record.turnedOver) {
+        ShowFromInTableau(move.from, next(fromPile.Begin(), fromSize));
+      }
+      break;
+    }
+    }
+
+    RefreshCards(move);
+    status = static_cast<Status>(record.status);
+    undone.push_back(move);
+    return true;
   }
 
-  void Board::DrawBoard() const {
+  bool Board::Redo() {
+    if (undone.empty()) {
+      return false;
+    }
+    Move move = undone.back();
+    undone.pop_back();
+
+    // playing the move clears the moves left to redo, so keep them aside;
+    // safe moves played after it were taken back too, and are redone as
+    // moves of their own
+    vector<Move> rest;
+    rest.swap(undone);
+    bool wasAutoPlay = autoPlay;
+    autoPlay = false;
+    bool played = ApplyMove(move);
+    autoPlay = wasAutoPlay;
+    undone.swap(rest);
+    return played;
+  }
+
+  bool Board::ValidMovesInFrame() const {
+    SOLITAIRE_COUNT(VALID_MOVES_CALLS, 1);
+    // any move but dealing a new talon
+    MoveBuffer moves;
+    GenerateMoves(moves);
+    return moves.Size() > (DeckEmpty() ? 0 : 1);
+  }
+
+  void Board::DrawBoard(ostream& out) const {
+    string frame;
+    frame.reserve(1024);
+    DrawFrame(frame);
+    out.write(frame.data(), frame.size());
+    out.flush();
+  }
+
+  void Board::DrawFrame(string& frame) const {
     // Display the stock area
     if (DeckEmpty()) {
-      cout << "EMPTY ";
+      frame += "EMPTY ";
     } else {
-      cout << "STOCK ";
+      frame += "STOCK ";
     }
 
     // Display the talon area
     if (TalonEmpty()) {
       for (int i = 0; i < numOpenCards; i++) {
-        cout << "--- ";
+        frame += "--- ";
       }
     } else {
       int n = 0;
-      for (CardPile::Pile::iterator it = talon; it != stock; ++it) {
-        cout << setw(2);
-        (*it).Print();
-        cout << " ";
+      for (int i = talon; i < stock; i++) {
+        deck[i].AppendTo(frame, 2);
+        frame += ' ';
         n++;
       }
       for (/**/; n < numOpenCards; n++) {
-        cout << "---";
+        frame += "---";
       }
     }
 
-    cout << "    ";
+    frame += "    ";
 
     // Display the foundation area
-    for (SuitPile pile : foundation) {
+    for (const SuitPile& pile : foundation) {
       if (pile.Empty()) {
-        cout << "--- ";
+        frame += "--- ";
       } else {
-        setw(2);
-        pile.Last().Print();
-        cout << " ";
+        pile.Last().AppendTo(frame);
+        frame += ' ';
       }
     }
-    cout << endl;
-    cout << endl;
+    frame += "\n\n";
 
     // Display the tableau area
-    int tableauSize = distance(tableau.begin(), tableau.end());
-    vector<CardPile::Pile::const_iterator> piles;
+    int tableauSize = tableau.size();
+    CardPile::Pile::const_iterator piles[kTableauSize];
+    bool shownStatus[kTableauSize] = { };
     for (int i = 0; i < tableauSize; i++) {
-      piles.push_back(tableau[i].Begin());
+      piles[i] = tableau[i].Begin();
     }
 
-    vector<bool> shownStatus(tableauSize);
-
     bool isTableauPrintingDone = true;
     do {
       isTableauPrintingDone = true;
       for (int i = 0; i < tableauSize; i++) {
         CardPile::Pile::const_iterator& cardIt = piles[i];
         if (cardIt == tableau[i].End()) {
-          cout << "    ";
+          frame += "    ";
         } else {
           isTableauPrintingDone = false;
           if (cardIt == tableau[i].cshown) {
             shownStatus[i] = true;
           }
           if (shownStatus[i]) {
-            cout << setw(2);
-            (*cardIt).Print();
+            cardIt->AppendTo(frame, 2);
           } else {
-            cout << "---";
+            frame += "---";
           }
-          cout << " ";
+          frame += ' ';
           ++cardIt;
         }
       }
-      cout << endl;
+      frame += '\n';
     } while (!isTableauPrintingDone);
-    cout << endl;
+    frame += '\n';
   }
 
 }
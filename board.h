@@ -5,16 +5,80 @@
  * @brief A Solitaire board.
  */
 #pragma once
+#include <cstdint>
 #include <iterator>
 #include <forward_list>
 #include <vector>
 #include "card.h"
+#include "move.h"
 
 namespace solitaire {
   const int kTableauSize = 7;
 
-  // forward declaration
+  /**
+   * The most moves that can be legal in one position.
+   */
+  const int kMaxMoves = 2 + kTableauSize * (kTableauSize + 1)
+    + kNumSuits * kTableauSize + kDeckSize;
+
+  /**
+   * MoveBuffer holds the legal moves of a position without allocating.
+   */
+  class MoveBuffer {
+  private:
+    Move moves[kMaxMoves];
+    int size;
+
+  public:
+    /**
+     * Creates an empty buffer.
+     */
+    MoveBuffer() : size(0) { }
+
+    /**
+     * Removes all moves from the buffer.
+     */
+    void Clear() { size = 0; }
+
+    /**
+     * Adds a move to the end of the buffer.
+     */
+    void PushBack(Move move) { moves[size++] = move; }
+
+    /**
+     * Removes the last move of the buffer.
+     */
+    void PopBack() { size--; }
+
+    /**
+     * Returns the number of moves in the buffer.
+     */
+    int Size() const { return size; }
+
+    /**
+     * Returns whether the buffer is empty.
+     */
+    bool Empty() const { return size == 0; }
+
+    /**
+     * Returns the move at the given index.
+     */
+    const Move& operator[](int i) const { return moves[i]; }
+
+    /**
+     * Returns a pointer to the first move.
+     */
+    const Move* Begin() const { return moves; }
+
+    /**
+     * Returns a pointer past the last move.
+     */
+    const Move* End() const { return moves + size; }
+  };
+
+  // forward declarations
   class Board;
+  struct PackedBoard;
 
   class CardPile {
   private:
@@ -62,11 +126,21 @@ namespace solitaire {
      */
     Card& Last();
 
+    /**
+     * Returns a pointer to the last element of the pile.
+     */
+    const Card& Last() const;
+
     /**
      * Returns an iterator that begins at the first element in the pile.
      */
     Pile::const_iterator Begin() const;
 
+    /**
+     * Returns an iterator that begins at the first element in the pile.
+     */
+    Pile::iterator Begin();
+
     /**
      * Returns an iterator that starts at the first position past the end of the
      * pile.
@@ -88,6 +162,11 @@ namespace solitaire {
      * Returns whether a pile is empty.
      */
     bool Empty() const;
+
+    /**
+     * Returns the number of cards in the pile.
+     */
+    int Size() const;
   };
 
   /**
@@ -102,6 +181,25 @@ namespace solitaire {
     Pile::const_iterator cshown;
     Pile::iterator shown;
 
+    /**
+     * Moves the face-up boundary to the given card, or to the end if the pile
+     * is empty.
+     */
+    void SetShown(Pile::iterator position);
+
+    /**
+     * Appends the cards from first to last to the pile. If the pile was empty,
+     * the new cards are all face up.
+     */
+    template <class InputIterator>
+      void Append(InputIterator first, InputIterator last);
+
+    /**
+     * Erases the face-up cards from position to the end of the pile, turning
+     * over the new last card if needed.
+     */
+    void EraseFrom(Pile::iterator position);
+
   public:
     using CardPile::CardPile;
 
@@ -151,26 +249,175 @@ namespace solitaire {
   public:
     enum class Status { STUCK, PLAYING, WON };
   private:
+    typedef std::vector<Card> Deck;
     typedef std::vector<SuitPile> Foundation;
     typedef std::vector<TableauPile> Tableau;
 
     int numOpenCards;
     mutable Status status;
-    CardPile::Pile::iterator* stuckState;
-    CardPile::Pile::iterator talon;
-    CardPile::Pile::iterator stock;
-    CardPile::Pile deck;
+
+    /**
+     * The stock and talon share one array: the talon is the cards from index
+     * talon up to index stock, and the stock the cards from index stock on.
+     * An index of the size of the deck is past its end, and the talon is
+     * empty when talon is.
+     */
+    int talon;
+    int stock;
+    Deck deck;
     Foundation foundation;
     Tableau tableau;
+    std::uint64_t hash;
 
     /**
-     * Returns true if there are valid moves to play in the current frame;
-     * otherwise, returns false.
+     * Sets of cards kept up to date move by move, as masks with the bit
+     * CodeOf(card) set for each card: the cards each tableau pile can take on
+     * top, and the face-up cards of each tableau pile.
      */
-    bool ValidMovesInFrame() const;
+    std::uint64_t tableauAccepts[kTableauSize];
+    std::uint64_t tableauShownCards[kTableauSize];
+
+    /**
+     * The number of face-down cards in the tableau, kept up to date move by
+     * move.
+     */
+    int numFaceDown;
+
+    /**
+     * The cards that can become the talon card by dealing new talons: the ones
+     * a pass from the beginning of the deck shows, which change only when a
+     * talon card is played, and the others the current pass still shows,
+     * which dealing a new talon only takes away from.
+     */
+    std::uint64_t deckReach;
+    std::uint64_t passReach;
+
+    /**
+     * The moves played so far, latest last, and the moves taken back since
+     * the last one played, latest taken back last.
+     */
+    std::vector<UndoRecord> history;
+    std::vector<Move> undone;
+
+    /**
+     * Whether every move is followed by the safe moves to the foundation it
+     * makes possible.
+     */
+    bool autoPlay;
 
     /**
-     * Updates the status of the game board accordingly.
+     * Returns the part of the hash that covers the stock and talon cursors.
+     */
+    std::uint64_t CursorHash() const;
+
+    /**
+     * Removes the accessible card from the talon.
+     */
+    void EraseTalonCard();
+
+    /**
+     * Puts a card taken from the talon back where it was and restores the
+     * cursors from before the move.
+     */
+    void InsertTalonCard(Card card, const UndoRecord& record);
+
+    /**
+     * Restores the talon and stock cursors from before the move.
+     */
+    void RestoreCursors(const UndoRecord& record);
+
+    /**
+     * Appends the cards from first to last to the tableau pile.
+     */
+    template <class InputIterator>
+      void AppendToTableau(Tableau::size_type tableauIdx, InputIterator first,
+                           InputIterator last);
+
+    /**
+     * Erases the cards from position to the end of the tableau pile. Returns
+     * true if it turned over a card.
+     */
+    bool EraseFromTableau(Tableau::size_type tableauIdx,
+                          CardPile::Pile::iterator position);
+
+    /**
+     * Turns the cards of the tableau pile from position to the end face up and
+     * the rest face down, which takes back EraseFromTableau turning over a
+     * card.
+     */
+    void ShowFromInTableau(Tableau::size_type tableauIdx,
+                           CardPile::Pile::iterator position);
+
+    /**
+     * Puts the card on top of the foundation pile.
+     */
+    void PushToFoundation(Foundation::size_type foundationIdx, Card card);
+
+    /**
+     * Removes the top card of the foundation pile.
+     */
+    void PopFromFoundation(Foundation::size_type foundationIdx);
+
+    /**
+     * Starts the undo record of a move about to be played.
+     */
+    UndoRecord StartRecord(Move move) const;
+
+    /**
+     * Adds the record of a move just played to the history.
+     */
+    void Played(const UndoRecord& record);
+
+
+    /**
+     * Returns the index of the first foundation pile the card can be built up
+     * on, or -1 if there is none.
+     */
+    int FoundationFor(Card card) const;
+
+    /**
+     * Returns how many cards a move from the source tableau pile to the
+     * destination tableau pile would carry, or 0 if there is no such move.
+     */
+    int CountToMove(Tableau::size_type fromIdx, Tableau::size_type toIdx) const;
+
+    /**
+     * Recomputes the card sets of the tableau pile.
+     */
+    void RefreshTableauCards(Tableau::size_type tableauIdx);
+
+    /**
+     * Recomputes the cards that can be reached as the talon card.
+     */
+    void RefreshTalonReach();
+
+    /**
+     * Recomputes the card sets of the piles the move changed, after it was
+     * played or taken back.
+     */
+    void RefreshCards(Move move);
+
+    /**
+     * Recomputes every card set.
+     */
+    void RefreshAllCards();
+
+    /**
+     * Returns true if a move other than dealing a new talon can be played now
+     * or after dealing some number of new talons.
+     */
+    bool HasReachableMove() const;
+
+    /**
+     * Plays safe moves to the foundation, each one in the history on its own,
+     * until there are none left.
+     */
+    void PlaySafeMoves();
+
+    /**
+     * Updates the status of the game board accordingly: won once nothing
+     * played can lose the game any more, as CanAutoComplete tells, and stuck
+     * once no move but dealing new talons is left, however many are dealt.
      */
     void UpdateStatus();
 
@@ -180,11 +427,59 @@ namespace solitaire {
      */
     Board(int numOpenCards = 3);
 
+    /**
+     * Creates a board with the game of the given deal number, which is the
+     * same deal every time.
+     */
+    Board(std::uint64_t dealNumber, int numOpenCards);
+
+    /**
+     * Creates a board holding the position stored in the packed board.
+     */
+    explicit Board(const PackedBoard& packed);
+
+    /**
+     * Copies the position and the move history of another board. The talon,
+     * stock and tableau cursors are iterators into the board's own piles, so
+     * they are rebuilt rather than copied.
+     */
+    Board(const Board& other);
+    Board& operator=(const Board& other);
+
+    /**
+     * Returns a packed copy of the current position.
+     */
+    PackedBoard Pack() const;
+
+    /**
+     * Replaces the current position with the one stored in the packed board,
+     * and works out its status from the position rather than taking the
+     * packed one on trust.
+     */
+    void Unpack(const PackedBoard& packed);
+
+    /**
+     * Returns a 64-bit Zobrist hash of the position, kept up to date by every
+     * move in constant time. Equal positions have equal hashes, and a Board
+     * hashes the same as its PackedBoard.
+     */
+    std::uint64_t Hash() const;
+
+    /**
+     * Computes the hash of the position from scratch.
+     */
+    std::uint64_t ComputeHash() const;
+
     /**
      * Resets the game board and deals a new game.
      */
     void Reset(int numOpenCards = 3);
 
+    /**
+     * Resets the game board and deals the game with the given deal number.
+     */
+    void Reset(int numOpenCards, std::uint64_t dealNumber);
+
     /**
      * Checks whether the talon is empty.
      */
@@ -213,12 +508,86 @@ namespace solitaire {
     /**
      * Returns an iterator to the accessible talon card.
      */
-    CardPile::Pile::const_iterator GetTalonCardIterator() const;
+    Deck::const_iterator GetTalonCardIterator() const;
 
     /**
      * Returns an iterator to the accessible talon card.
      */
-    CardPile::Pile::iterator GetTalonCardIterator();
+    Deck::iterator GetTalonCardIterator();
+
+    /**
+     * Returns how many new talons it takes to make the card the talon card,
+     * 0 if it is already, or -1 if no number does. Cards that some number
+     * does are kept as a set move by move, so most cards are answered
+     * without looking for them in the deck.
+     */
+    int NewTalonsToReach(Card card) const;
+
+    /**
+     * Fills the buffer with every legal move, with moves to the foundation
+     * first and the new talon last, in the same order as
+     * PackedBoard::GenerateMoves.
+     */
+    void GenerateMoves(MoveBuffer& moves) const;
+
+    /**
+     * Returns true if there are valid moves to play in the current frame;
+     * otherwise, returns false.
+     */
+    bool ValidMovesInFrame() const;
+
+    /**
+     * Finds a move to the foundation that no line of play needs to put off,
+     * by the same rule as PackedBoard::FindSafeMove. Returns false if there
+     * is none.
+     */
+    bool FindSafeMove(Move& move) const;
+
+    /**
+     * Returns whether the game is won whatever is played next, by the same
+     * rule as PackedBoard::CanAutoComplete, which holds once every card is on
+     * the foundation and often well before. Takes constant time.
+     */
+    bool CanAutoComplete() const;
+
+    /**
+     * Plays out a game that CanAutoComplete says is won, by the moves
+     * PackedBoard::AutoComplete picks, each in the history on its own.
+     * Returns false and plays nothing if the game is not won yet, or if those
+     * moves get stuck.
+     */
+    bool AutoComplete();
+
+    /**
+     * Turns auto-play on or off. While it is on, every Do* move and every new
+     * deal is followed by the safe moves to the foundation; turning it on
+     * plays the ones there are now. Undo takes them back one at a time.
+     */
+    void SetAutoPlay(bool autoPlay);
+
+    /**
+     * Returns whether auto-play is on.
+     */
+    bool GetAutoPlay() const;
+
+    /**
+     * Plays the move through the Do* method it names, dealing as many new
+     * talons as the count of a NEW_TALON move says. Returns false if the move
+     * is illegal.
+     */
+    bool ApplyMove(Move move);
+
+    /**
+     * Takes back the last move played, restoring the position, its hash and
+     * the status exactly. Returns false if there is no move to take back.
+     */
+    bool Undo();
+
+    /**
+     * Plays again the last move taken back. Returns false if there is none,
+     * or if a move was played since.
+     */
+    bool Redo();
 
     /**
      * Flip over three more cards to the talon.
@@ -228,7 +597,7 @@ namespace solitaire {
     /**
      * Get a hint.
      */
-    void DoGetHint();
+    void DoGetHint() const;
 
     /**
      * Move the talon card to the foundation.
@@ -261,7 +630,12 @@ namespace solitaire {
     /**
      * Draws the board to be displayed through the command line.
      */
-    void DrawBoard() const;
+    void DrawBoard(std::ostream& out = std::cout) const;
+
+    /**
+     * Appends the board to the frame in the layout DrawBoard draws.
+     */
+    void DrawFrame(std::string& frame) const;
 
     /**
      * Returns the current status of the game.
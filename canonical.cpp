@@ -0,0 +1,186 @@
+/**
+ * @file canonical.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief One representative of each class of equivalent positions.
+ */
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include "canonical.h"
+#include "zobrist.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * SuitRenamings holds, for each renaming, the code each card code becomes.
+   * Codes that are not cards, such as kNoCard, stay as they are.
+   */
+  struct SuitRenamings {
+    CardCode cards[kNumSuitRenamings][256];
+
+    SuitRenamings() {
+      for (int renaming = 0; renaming < kNumSuitRenamings; renaming++) {
+        // suits alternate black and red, so spades and clubs are 0 and 2,
+        // hearts and diamonds 1 and 3
+        int suits[kNumSuits] = { 0, 1, 2, 3 };
+        if (renaming & 1) {
+          swap(suits[0], suits[2]);
+        }
+        if (renaming & 2) {
+          swap(suits[1], suits[3]);
+        }
+        if (renaming & 4) {
+          swap(suits[0], suits[1]);
+          swap(suits[2], suits[3]);
+        }
+        for (int code = 0; code < 256; code++) {
+          cards[renaming][code] = code < kDeckSize
+            ? suits[code / kNumRanks] * kNumRanks + code % kNumRanks : code;
+        }
+      }
+    }
+  };
+
+  static const SuitRenamings kSuitRenamings;
+
+  /**
+   * Sets renamed to the position with its suits renamed, leaving its hashes
+   * unset.
+   */
+  static void Rename(const PackedBoard& board, const CardCode* rename,
+                     PackedBoard& renamed) {
+    renamed = board;
+    for (int i = 0; i < board.deckSize; i++) {
+      renamed.deck[i] = rename[board.deck[i]];
+    }
+    for (int i = 0; i < kNumSuits; i++) {
+      renamed.foundation[i] = rename[board.foundation[i]];
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      for (int j = 0; j < board.tableauSize[i]; j++) {
+        renamed.tableau[i][j] = rename[board.tableau[i][j]];
+      }
+    }
+  }
+
+  /**
+   * Returns the hash of the order of the deck: the key of each card with the
+   * card after it.
+   */
+  static uint64_t DeckOrderHash(const PackedBoard& board) {
+    uint64_t hash = 0;
+    for (int i = 0; i < board.deckSize; i++) {
+      hash ^= NextKey(board.deck[i],
+                      i + 1 < board.deckSize ? board.deck[i + 1] : kNoCard);
+    }
+    return hash;
+  }
+
+  /**
+   * Returns the canonical hash of the position with its suits renamed: its
+   * symmetric hash with the order of its deck.
+   */
+  static uint64_t HashUnder(const PackedBoard& board, const CardCode* rename) {
+    PackedBoard renamed;
+    Rename(board, rename, renamed);
+    return renamed.ComputeSymmetricHash() ^ DeckOrderHash(renamed);
+  }
+
+  uint64_t CanonicalHash(const PackedBoard& board) {
+    uint64_t hash = HashUnder(board, kSuitRenamings.cards[0]);
+    for (int renaming = 1; renaming < kNumSuitRenamings; renaming++) {
+      hash = min(hash, HashUnder(board, kSuitRenamings.cards[renaming]));
+    }
+    return hash;
+  }
+
+  /**
+   * Sets canonical to the renamed position with each foundation pile at the
+   * index of its suit and the tableau piles sorted, leaving its hashes unset.
+   */
+  static void Arrange(const PackedBoard& renamed, PackedBoard& canonical) {
+    canonical = renamed;
+    fill(canonical.foundation, canonical.foundation + kNumSuits, kNoCard);
+    for (CardCode top : renamed.foundation) {
+      if (top != kNoCard) {
+        canonical.foundation[top / kNumRanks] = top;
+      }
+    }
+
+    // nonempty piles by their bottom card, which no other pile shares, and
+    // then the empty ones
+    int order[kTableauSize];
+    for (int i = 0; i < kTableauSize; i++) {
+      order[i] = i;
+    }
+    auto keyOf = [&](int pile) {
+      return renamed.tableauSize[pile] == 0 ? INT_MAX
+        : int(renamed.tableau[pile][0]);
+    };
+    sort(order, order + kTableauSize,
+         [&](int a, int b) { return keyOf(a) < keyOf(b); });
+    for (int i = 0; i < kTableauSize; i++) {
+      int pile = order[i];
+      canonical.tableauSize[i] = renamed.tableauSize[pile];
+      canonical.tableauShown[i] = renamed.tableauShown[pile];
+      int size = renamed.tableauSize[pile];
+      copy(renamed.tableau[pile], renamed.tableau[pile] + size,
+           canonical.tableau[i]);
+      // past the end of a pile or the deck, the bytes of equivalent positions
+      // would otherwise hold whatever was left there
+      fill(canonical.tableau[i] + size,
+           canonical.tableau[i] + kMaxTableauPileSize, kNoCard);
+    }
+    fill(canonical.deck + canonical.deckSize, canonical.deck + kMaxDeckSize,
+         kNoCard);
+  }
+
+  /**
+   * Checks whether the cards of the first arranged position come before
+   * those of the second, byte by byte.
+   */
+  static bool CardsBefore(const PackedBoard& a, const PackedBoard& b) {
+    int order = memcmp(a.deck, b.deck, sizeof(a.deck));
+    if (order == 0) {
+      order = memcmp(a.foundation, b.foundation, sizeof(a.foundation));
+    }
+    if (order == 0) {
+      order = memcmp(a.tableauSize, b.tableauSize, sizeof(a.tableauSize));
+    }
+    if (order == 0) {
+      order = memcmp(a.tableauShown, b.tableauShown, sizeof(a.tableauShown));
+    }
+    if (order == 0) {
+      order = memcmp(a.tableau, b.tableau, sizeof(a.tableau));
+    }
+    return order < 0;
+  }
+
+  void Canonicalize(const PackedBoard& board, PackedBoard& canonical) {
+    uint64_t hashes[kNumSuitRenamings];
+    for (int renaming = 0; renaming < kNumSuitRenamings; renaming++) {
+      hashes[renaming] = HashUnder(board, kSuitRenamings.cards[renaming]);
+    }
+    uint64_t hash = *min_element(hashes, hashes + kNumSuitRenamings);
+
+    // a renaming that leaves the hash as is most often leaves the position
+    // as is too, but the bytes decide
+    bool found = false;
+    for (int renaming = 0; renaming < kNumSuitRenamings; renaming++) {
+      if (hashes[renaming] != hash) {
+        continue;
+      }
+      PackedBoard renamed;
+      PackedBoard arranged;
+      Rename(board, kSuitRenamings.cards[renaming], renamed);
+      Arrange(renamed, arranged);
+      if (!found || CardsBefore(arranged, canonical)) {
+        canonical = arranged;
+        found = true;
+      }
+    }
+    canonical.ResetHashes();
+  }
+}
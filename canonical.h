@@ -0,0 +1,41 @@
+/**
+ * @file canonical.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief One representative of each class of equivalent positions.
+ */
+#pragma once
+#include <cstdint>
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * The number of ways to rename the suits without changing the game: swap
+   * spades with clubs or not, hearts with diamonds or not, and the black
+   * suits with the red ones or not. Each keeps which suits are of opposite
+   * colors, which is all the rules look at.
+   */
+  const int kNumSuitRenamings = 8;
+
+  /**
+   * Returns a hash of the position that is the same for every position that
+   * plays the same: one with its suits renamed as above, its foundation piles
+   * in another order, or its tableau piles in another order. Unlike the
+   * symmetric hash, it keys the order of the deck, so positions of different
+   * deals whose stock holds the same cards in another order differ. It is not
+   * the position's Zobrist hash, and costs a pass over the cards for each
+   * renaming.
+   */
+  std::uint64_t CanonicalHash(const PackedBoard& board);
+
+  /**
+   * Sets canonical to the representative of the position's class: the
+   * renaming with the smallest CanonicalHash, with each foundation pile at
+   * the index of its suit and the nonempty tableau piles sorted by their
+   * bottom card, ahead of the empty ones. Of renamings with the same hash,
+   * the one whose cards come first byte by byte wins, so equivalent
+   * positions give the same bytes even then, and the representative can be
+   * compared and stored as is.
+   */
+  void Canonicalize(const PackedBoard& board, PackedBoard& canonical);
+}
@@ -18,40 +18,39 @@ namespace solitaire {
   }
 
   Card::Card(Rank rank, Suit suit)
-    : rank(rank),
-      suit(suit) { }
+    : code(IntOf(suit) * kNumRanks + IntOf(rank) - 1) { }
 
   Rank Card::GetRank() const {
-    return rank;
+    return static_cast<Rank>(code % kNumRanks + 1);
   }
 
   Suit Card::GetSuit() const {
-    return suit;
+    return static_cast<Suit>(code / kNumRanks);
   }
 
-  string StringOf(Rank rank) {
-    return (string []) { "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J",
-        "Q", "K" }[IntOf(rank) - 1];
-  }
-
-  string StringOf(Suit suit) {
-    return (string []) { "♠", "♥", "♣", "♦" }[IntOf(suit)];
+  void Card::Print(ostream& out) const {
+    out << StringOf(GetRank()) << StringOf(GetSuit());
   }
 
-  void Card::Print(ostream& out) const {
-    out << StringOf(rank) << StringOf(suit);
+  void Card::AppendTo(string& out, int width) const {
+    string_view rankString = StringOf(GetRank());
+    for (int i = rankString.size(); i < width; i++) {
+      out += ' ';
+    }
+    out += rankString;
+    out += StringOf(GetSuit());
   }
 
   bool Card::RankOneLessThan(Card card) const {
-    return IntOf(rank) + 1 == IntOf(card.rank);
+    return IntOf(GetRank()) + 1 == IntOf(card.GetRank());
   }
 
   bool Card::SuitSameAs(Card card) const {
-    return suit == card.suit;
+    return GetSuit() == card.GetSuit();
   }
 
   bool Card::SuitOppositeColorFrom(Card card) const {
-    return IntOf(suit) % 2 != IntOf(card.suit) % 2;
+    return IntOf(GetSuit()) % 2 != IntOf(card.GetSuit()) % 2;
   }
 
   bool Card::IsKing() const {
@@ -62,4 +61,12 @@ namespace solitaire {
     return GetRank() == Rank::_A;
   }
 
+  CardCode CodeOf(Card card) {
+    return card.code;
+  }
+
+  Card CardOf(CardCode code) {
+    return Card(code);
+  }
+
 }
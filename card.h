@@ -5,23 +5,45 @@
  * @brief Models a playing card.
  */
 #pragma once
+#include <cstdint>
 #include <iostream>
 #include <list>
 #include <ostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace solitaire {
   const int kNumSuits = 4;
+  const int kNumRanks = 13;
   const int kDeckSize = 52;
 
-  enum class Rank { _A = 1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _J, _Q, _K };
-  enum class Suit { SPADES, HEARTS, CLUBS, DIAMONDS };
+  enum class Rank : std::uint8_t {
+    _A = 1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _J, _Q, _K
+  };
+  enum class Suit : std::uint8_t { SPADES, HEARTS, CLUBS, DIAMONDS };
+
+  /**
+   * A card packed into a single byte as 13 * suit + rank - 1.
+   */
+  typedef std::uint8_t CardCode;
+
+  /**
+   * The code of an empty slot.
+   */
+  const CardCode kNoCard = 0xff;
 
+  /**
+   * A card, stored as its CardCode so that it fits in one byte.
+   */
   class Card {
   private:
-    Rank rank;
-    Suit suit;
+    CardCode code;
+
+    explicit Card(CardCode code) : code(code) { }
+
+    friend CardCode CodeOf(Card card);
+    friend Card CardOf(CardCode code);
 
   public:
     /**
@@ -44,6 +66,12 @@ namespace solitaire {
      */
     void Print(std::ostream& out = std::cout) const;
 
+    /**
+     * Appends the card to the string as Print prints it, with the rank padded
+     * on the left to the given width.
+     */
+    void AppendTo(std::string& out, int width = 0) const;
+
     /**
      * Compares the ranks of two cards.
      */
@@ -80,16 +108,45 @@ namespace solitaire {
    */
   int IntOf(Suit suit);
 
+  static_assert(sizeof(Card) == 1, "Card must pack into one byte");
+
+  /**
+   * The glyphs printed for each rank, from ace to king.
+   */
+  inline constexpr std::string_view kRankGlyphs[kNumRanks] = {
+    "A", "2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K"
+  };
+
+  /**
+   * The glyphs printed for each suit, in the order of the suit enum.
+   */
+  inline constexpr std::string_view kSuitGlyphs[kNumSuits] = {
+    "♠", "♥", "♣", "♦"
+  };
+
   /**
    * Given a rank, return the string of the letter of the card.
    */
-  std::string StringOf(Rank rank);
+  constexpr std::string_view StringOf(Rank rank) {
+    return kRankGlyphs[static_cast<int>(rank) - 1];
+  }
 
   /**
    * Given a suit, return the string of the character of the suit.
    */
-  std::string StringOf(Suit suit);
+  constexpr std::string_view StringOf(Suit suit) {
+    return kSuitGlyphs[static_cast<int>(suit)];
+  }
 
+  /**
+   * Returns the packed code of the card.
+   */
+  CardCode CodeOf(Card card);
+
+  /**
+   * Returns the card behind the packed code.
+   */
+  Card CardOf(CardCode code);
 
 
 }
@@ -0,0 +1,215 @@
+/**
+ * @file corpus.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A binary file of labeled Solitaire deals and their solutions.
+ */
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "deal.h"
+#include "solitaire.h"
+
+namespace solitaire {
+  using namespace std;
+
+  static const char kMagic[8] = { 'S', 'O', 'L', 'C', 'O', 'R', 'P', 'S' };
+  static const uint32_t kVersion = 1;
+
+  DealRecord RecordOf(uint64_t dealNumber, int numOpenCards) {
+    DealRecord record = { };
+    record.dealNumber = dealNumber;
+    ShuffleDeal(dealNumber, record.cards);
+    record.numOpenCards = numOpenCards;
+    record.label = DealLabel::UNKNOWN;
+    return record;
+  }
+
+  CorpusReader::CorpusReader()
+    : data(nullptr), size(0), header(nullptr), records(nullptr),
+      index(nullptr), moves(nullptr) { }
+
+  CorpusReader::~CorpusReader() {
+    Close();
+  }
+
+  /**
+   * Returns true if the section of count items of the given size at the
+   * offset lies inside a file of the given size.
+   */
+  static bool FitsIn(size_t fileSize, uint64_t offset, uint64_t count,
+                     size_t itemSize) {
+    return offset <= fileSize && count <= (fileSize - offset) / itemSize;
+  }
+
+  /**
+   * Returns true if the record holds a game the engine can play: every card
+   * once, a draw count of 1 or 3 and a known label.
+   */
+  static bool IsValidRecord(const DealRecord& record) {
+    if ((record.numOpenCards != kOneCardGame
+         && record.numOpenCards != kThreeCardGame)
+        || record.label > DealLabel::UNKNOWN) {
+      return false;
+    }
+    bool seen[kDeckSize] = { };
+    for (CardCode card : record.cards) {
+      if (card >= kDeckSize || seen[card]) {
+        return false;
+      }
+      seen[card] = true;
+    }
+    return true;
+  }
+
+  bool CorpusReader::Open(const string& path) {
+    Close();
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || size_t(info.st_size) < sizeof(CorpusHeader)) {
+      close(fd);
+      return false;
+    }
+    void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+      return false;
+    }
+    data = static_cast<const unsigned char*>(mapping);
+    size = info.st_size;
+
+    header = reinterpret_cast<const CorpusHeader*>(data);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0
+        || header->version != kVersion
+        || header->recordSize != sizeof(DealRecord)
+        || header->numDeals >= size
+        || !FitsIn(size, header->recordsOffset, header->numDeals,
+                   sizeof(DealRecord))
+        || !FitsIn(size, header->indexOffset, header->numDeals + 1,
+                   sizeof(uint64_t))
+        || !FitsIn(size, header->movesOffset, header->numMoves, sizeof(Move))
+        || header->recordsOffset % alignof(DealRecord) != 0
+        || header->indexOffset % alignof(uint64_t) != 0) {
+      Close();
+      return false;
+    }
+    const unsigned char* base = data;
+    records = reinterpret_cast<const DealRecord*>(base + header->recordsOffset);
+    index = reinterpret_cast<const uint64_t*>(base + header->indexOffset);
+    moves = reinterpret_cast<const Move*>(base + header->movesOffset);
+
+    // a solution must lie inside the moves section, and its deal be one
+    // that can be played
+    for (uint64_t i = 0; i < header->numDeals; i++) {
+      if (index[i] > index[i + 1] || index[i + 1] > header->numMoves
+          || !IsValidRecord(records[i])) {
+        Close();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void CorpusReader::Close() {
+    if (data != nullptr) {
+      munmap(const_cast<unsigned char*>(data), size);
+    }
+    data = nullptr;
+    size = 0;
+    header = nullptr;
+    records = nullptr;
+    index = nullptr;
+    moves = nullptr;
+  }
+
+  uint64_t CorpusReader::NumDeals() const {
+    return header == nullptr ? 0 : header->numDeals;
+  }
+
+  const DealRecord& CorpusReader::GetDeal(uint64_t i) const {
+    return records[i];
+  }
+
+  const Move* CorpusReader::SolutionBegin(uint64_t i) const {
+    return moves + index[i];
+  }
+
+  const Move* CorpusReader::SolutionEnd(uint64_t i) const {
+    return moves + index[i + 1];
+  }
+
+  CorpusWriter::CorpusWriter() : file(nullptr), failed(false) { }
+
+  CorpusWriter::~CorpusWriter() {
+    if (file != nullptr) {
+      Close();
+    }
+  }
+
+  bool CorpusWriter::Open(const string& path) {
+    file = fopen(path.c_str(), "wb");
+    records.clear();
+    index.assign(1, 0);
+    failed = file == nullptr;
+
+    // leave room for the header, which is written last
+    CorpusHeader header = { };
+    if (!failed && fwrite(&header, sizeof(header), 1, file) != 1) {
+      failed = true;
+    }
+    return !failed;
+  }
+
+  void CorpusWriter::Add(const DealRecord& record, const Move* first,
+                         const Move* last) {
+    size_t count = last - first;
+    if (count > 0 && fwrite(first, sizeof(Move), count, file) != count) {
+      failed = true;
+    }
+    records.push_back(record);
+    index.push_back(index.back() + count);
+  }
+
+  bool CorpusWriter::Close() {
+    if (file == nullptr) {
+      return false;
+    }
+    CorpusHeader header = { };
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.recordSize = sizeof(DealRecord);
+    header.numDeals = records.size();
+    header.numMoves = index.back();
+    header.movesOffset = sizeof(CorpusHeader);
+
+    // pad the end of the moves so the records and index are aligned
+    uint64_t end = header.movesOffset + header.numMoves * sizeof(Move);
+    static const char kPadding[sizeof(uint64_t)] = { };
+    size_t padding = (sizeof(uint64_t) - end % sizeof(uint64_t))
+      % sizeof(uint64_t);
+    header.recordsOffset = end + padding;
+    header.indexOffset = header.recordsOffset
+      + records.size() * sizeof(DealRecord);
+
+    if (fwrite(kPadding, 1, padding, file) != padding
+        || fwrite(records.data(), sizeof(DealRecord), records.size(), file)
+           != records.size()
+        || fwrite(index.data(), sizeof(uint64_t), index.size(), file)
+           != index.size()
+        || fseek(file, 0, SEEK_SET) != 0
+        || fwrite(&header, sizeof(header), 1, file) != 1) {
+      failed = true;
+    }
+    if (fclose(file) != 0) {
+      failed = true;
+    }
+    file = nullptr;
+    return !failed;
+  }
+}
@@ -0,0 +1,155 @@
+/**
+ * @file corpus.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A binary file of labeled Solitaire deals and their solutions.
+ */
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * What is known about whether a deal can be won. The first three match
+   * Solver::Result.
+   */
+  enum class DealLabel : std::uint8_t { SOLVED, UNSOLVABLE, GAVE_UP, UNKNOWN };
+
+  /**
+   * DealRecord is one deal of a corpus file: the cards in the order
+   * PackedBoard::Deal lays them out, and the label found for it.
+   */
+  struct DealRecord {
+    std::uint64_t dealNumber;
+    CardCode cards[kDeckSize];
+    std::uint8_t numOpenCards;
+    DealLabel label;
+    std::uint8_t reserved[2];
+
+    /**
+     * Deals the record's game onto the board.
+     */
+    void Deal(PackedBoard& board) const {
+      board.Deal(cards, numOpenCards);
+    }
+  };
+
+  /**
+   * Returns the unlabeled record of the deal with the given number.
+   */
+  DealRecord RecordOf(std::uint64_t dealNumber, int numOpenCards);
+
+  static_assert(sizeof(DealRecord) == 64, "DealRecord must be 64 bytes");
+  static_assert(sizeof(Move) == 4, "Move must be 4 bytes");
+
+  /**
+   * CorpusHeader starts a corpus file. The file holds, at the offsets the
+   * header gives, numDeals DealRecords, an index of numDeals + 1 move
+   * offsets, and numMoves Moves. The solution of deal i is the moves from
+   * index[i] up to but not including index[i + 1]. Numbers are stored in
+   * the byte order of the machine that wrote the file.
+   */
+  struct CorpusHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t recordSize;
+    std::uint64_t numDeals;
+    std::uint64_t numMoves;
+    std::uint64_t recordsOffset;
+    std::uint64_t indexOffset;
+    std::uint64_t movesOffset;
+    std::uint64_t reserved;
+  };
+
+  /**
+   * CorpusReader maps a corpus file into memory and reads records and
+   * solutions straight out of the mapping, without copying or parsing them.
+   */
+  class CorpusReader {
+  private:
+    const unsigned char* data;
+    std::size_t size;
+    const CorpusHeader* header;
+    const DealRecord* records;
+    const std::uint64_t* index;
+    const Move* moves;
+
+  public:
+    CorpusReader();
+    ~CorpusReader();
+
+    CorpusReader(const CorpusReader&) = delete;
+    CorpusReader& operator=(const CorpusReader&) = delete;
+
+    /**
+     * Maps the corpus file at the path. Returns false if it cannot be read or
+     * is not a well-formed corpus, which includes a record whose cards are not
+     * each card once or whose draw count is not 1 or 3.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Unmaps the file.
+     */
+    void Close();
+
+    /**
+     * Returns the number of deals in the corpus.
+     */
+    std::uint64_t NumDeals() const;
+
+    /**
+     * Returns the record of the deal at the index.
+     */
+    const DealRecord& GetDeal(std::uint64_t i) const;
+
+    /**
+     * Returns the first move of the solution of the deal at the index.
+     */
+    const Move* SolutionBegin(std::uint64_t i) const;
+
+    /**
+     * Returns the end of the solution of the deal at the index.
+     */
+    const Move* SolutionEnd(std::uint64_t i) const;
+  };
+
+  /**
+   * CorpusWriter writes a corpus file one deal at a time. Solutions go to the
+   * file as they come; the records and the index are kept until Close writes
+   * them after the solutions.
+   */
+  class CorpusWriter {
+  private:
+    std::FILE* file;
+    std::vector<DealRecord> records;
+    std::vector<std::uint64_t> index;
+    bool failed;
+
+  public:
+    CorpusWriter();
+    ~CorpusWriter();
+
+    CorpusWriter(const CorpusWriter&) = delete;
+    CorpusWriter& operator=(const CorpusWriter&) = delete;
+
+    /**
+     * Creates the corpus file at the path. Returns false if it cannot.
+     */
+    bool Open(const std::string& path);
+
+    /**
+     * Adds a deal and its solution, which may be empty.
+     */
+    void Add(const DealRecord& record, const Move* first, const Move* last);
+
+    /**
+     * Writes the records, the index and the header and closes the file.
+     * Returns false if any write failed.
+     */
+    bool Close();
+  };
+}
@@ -0,0 +1,42 @@
+/**
+ * @file deal.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Numbered, reproducible Solitaire deals.
+ */
+#include <chrono>
+#include <random>
+#include "deal.h"
+
+namespace solitaire {
+  using namespace std;
+
+  void ShuffleDeal(uint64_t dealNumber, CardCode* cards) {
+    for (int i = 0; i < kDeckSize; i++) {
+      cards[i] = i;
+    }
+
+    // Fisher-Yates from the top of the deck down
+    SplitMix64 random(dealNumber);
+    for (int i = kDeckSize - 1; i > 0; i--) {
+      int j = random.Below(i + 1);
+      CardCode card = cards[i];
+      cards[i] = cards[j];
+      cards[j] = card;
+    }
+  }
+
+  void ShuffleDeals(uint64_t first, uint64_t count, CardCode* cards) {
+    for (uint64_t i = 0; i < count; i++, cards += kDeckSize) {
+      ShuffleDeal(first + i, cards);
+    }
+  }
+
+  uint64_t RandomDealNumber() {
+    // mix the clock in case random_device is deterministic on this platform
+    random_device device;
+    uint64_t number = (uint64_t(device()) << 32) ^ device();
+    return number
+      ^ chrono::high_resolution_clock::now().time_since_epoch().count();
+  }
+}
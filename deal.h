@@ -0,0 +1,70 @@
+/**
+ * @file deal.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Numbered, reproducible Solitaire deals.
+ */
+#pragma once
+#include <cstdint>
+#include "card.h"
+
+namespace solitaire {
+  /**
+   * SplitMix64 is a small, fast generator of 64-bit numbers. Unlike the
+   * standard library's engines and distributions together, the numbers it
+   * gives for a seed are fixed on every platform and compiler.
+   */
+  class SplitMix64 {
+  private:
+    std::uint64_t state;
+
+  public:
+    explicit SplitMix64(std::uint64_t seed) : state(seed) { }
+
+    /**
+     * Returns the next number of the sequence.
+     */
+    std::uint64_t Next() {
+      std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
+    }
+
+    /**
+     * Returns a number from 0 up to but not including bound, with every
+     * number equally likely.
+     */
+    std::uint32_t Below(std::uint32_t bound) {
+      // scale a 32-bit number to the bound, retrying the few numbers that
+      // would make some results likelier than others
+      std::uint64_t product = (Next() >> 32) * bound;
+      if (static_cast<std::uint32_t>(product) < bound) {
+        std::uint32_t threshold = -bound % bound;
+        while (static_cast<std::uint32_t>(product) < threshold) {
+          product = (Next() >> 32) * bound;
+        }
+      }
+      return product >> 32;
+    }
+  };
+
+  /**
+   * Writes the cards of the deal with the given number to cards, which must
+   * hold kDeckSize card codes. The deal is a shuffle of the cards in code
+   * order drawn from SplitMix64 seeded with the deal number, so a number
+   * names the same deal on every machine and in every version.
+   */
+  void ShuffleDeal(std::uint64_t dealNumber, CardCode* cards);
+
+  /**
+   * Writes the count deals numbered from first on, one after another, to
+   * cards, which must hold count * kDeckSize card codes.
+   */
+  void ShuffleDeals(std::uint64_t first, std::uint64_t count, CardCode* cards);
+
+  /**
+   * Returns a deal number that differs from run to run and call to call.
+   */
+  std::uint64_t RandomDealNumber();
+}
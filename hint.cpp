@@ -0,0 +1,252 @@
+/**
+ * @file hint.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Looks for the best move of a position in the background.
+ */
+#include <algorithm>
+#include <climits>
+#include "hint.h"
+#include "solver.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  constexpr double HintSearch::kDefaultSeconds;
+  const size_t HintSearch::kDefaultMegabytes;
+
+  /**
+   * The deepest the search goes, in moves.
+   */
+  static const int kMaxDepth = 64;
+
+  /**
+   * The number of positions searched between checks of the clock.
+   */
+  static const uint64_t kCheckInterval = 1024;
+
+  /**
+   * The value of a line that cannot be played.
+   */
+  static const int kNoValue = INT_MIN;
+
+  /**
+   * What a card is worth in each place. Values are scaled by kMaxDepth and
+   * lose one per move, so that of two equal lines the shorter one wins.
+   */
+  static const int kFoundationScore = 10;
+  static const int kFaceDownScore = -8;
+  static const int kDeckScore = -1;
+  static const int kWonScore = kDeckSize * kFoundationScore + 1;
+
+  /**
+   * The order moves of each PriorityOf rank are tried in. Of moves that lead to
+   * equally good lines the first one tried wins, so splitting a run or taking
+   * a card back off the foundation comes last, after even a new talon.
+   */
+  static const int kTryOrder[kNumPriorities] = { 0, 1, 2, 3, 5, 4, 6 };
+
+  /**
+   * Returns the value of the position reached after ply moves.
+   */
+  static int ValueOf(const PackedBoard& board, int ply) {
+    int score = 0;
+    if (board.CanAutoComplete()) {
+      score = kWonScore;
+    } else {
+      for (int i = 0; i < kNumSuits; i++) {
+        if (board.foundation[i] != kNoCard) {
+          score += kFoundationScore * (board.foundation[i] % kNumRanks + 1);
+        }
+      }
+      score += kFaceDownScore * board.numFaceDown;
+      score += kDeckScore * board.deckSize;
+    }
+    return score * kMaxDepth - ply;
+  }
+
+  /**
+   * Checks whether the new talon just dealt flipped a card not in the mask of
+   * cards seen.
+   */
+  static bool ShowsUnseen(const PackedBoard& board, uint64_t seenCards) {
+    for (int i = board.talon; i < board.stock; i++) {
+      if ((seenCards >> board.deck[i] & 1) == 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  HintSearch::HintSearch(double seconds, size_t megabytes)
+    : seconds(seconds), generation(0), nodes(0), aborted(false),
+      cutOff(false), seenCards(0), started(false), stopping(false), found(false),
+      bestDepth(0) {
+    // a power of two number of entries that fits in the memory budget
+    size_t numEntries = 1024;
+    while (numEntries * 2 * sizeof(Entry) <= megabytes << 20) {
+      numEntries *= 2;
+    }
+    table.resize(numEntries);
+  }
+
+  HintSearch::~HintSearch() {
+    Stop();
+  }
+
+  void HintSearch::Start(const PackedBoard& position) {
+    if (started && position.Hash() == root.Hash()) {
+      return;
+    }
+    Stop();
+    root = position;
+    started = true;
+    {
+      lock_guard<std::mutex> lock(mutex);
+      found = false;
+    }
+    stopping = false;
+    deadline = chrono::steady_clock::now()
+      + chrono::duration_cast<chrono::steady_clock::duration>(
+          chrono::duration<double>(seconds));
+    thread = std::thread(&HintSearch::Run, this);
+  }
+
+  void HintSearch::Stop() {
+    stopping = true;
+    if (thread.joinable()) {
+      thread.join();
+    }
+  }
+
+  bool HintSearch::GetBest(Move& move, int& depth) const {
+    lock_guard<std::mutex> lock(mutex);
+    move = best;
+    depth = bestDepth;
+    return found;
+  }
+
+  bool HintSearch::Visit(uint64_t hash, int depth) {
+    Entry& entry = table[hash & (table.size() - 1)];
+    if (entry.hash == hash && entry.generation == generation
+        && entry.depth >= depth) {
+      return false;
+    }
+    entry = { hash, uint8_t(depth), generation };
+    return true;
+  }
+
+  void HintSearch::Run() {
+    SOLITAIRE_TIME(HINT_SEARCH);
+    nodes = 0;
+    aborted = false;
+
+    PackedBoard board = root;
+    // every card before the stock cursor was flipped in this pass; the ones
+    // after it may never have been
+    seenCards = 0;
+    for (int i = 0; i < board.stock; i++) {
+      seenCards |= uint64_t(1) << board.deck[i];
+    }
+    for (int depth = 1; depth <= kMaxDepth && !board.CanAutoComplete();
+         depth++) {
+      // entries of earlier iterations are stale; clear them all only when the
+      // generation wraps around
+      if (++generation == 0) {
+        fill(table.begin(), table.end(), Entry());
+        generation = 1;
+      }
+      Visit(board.SymmetricHash(), depth);
+      Move move;
+      cutOff = false;
+      int value = WithDrawCount(board.numOpenCards, [&](auto drawCount) {
+          return Search<decltype(drawCount)::value>(board, depth, 0, &move);
+        });
+      if (aborted || value == kNoValue) {
+        break;
+      }
+      {
+        lock_guard<std::mutex> lock(mutex);
+        found = true;
+        best = move;
+        bestDepth = depth;
+      }
+      // every line ended before the depth limit, so going deeper finds nothing
+      if (!cutOff) {
+        break;
+      }
+    }
+  }
+
+  template <int kDrawCount>
+  int HintSearch::Search(PackedBoard& board, int depth, int ply,
+                         Move* bestMove) {
+    // the player may stop following a line anywhere, but must move at the root
+    int value = bestMove != nullptr ? kNoValue : ValueOf(board, ply);
+    if (depth == 0) {
+      cutOff = true;
+      return value;
+    }
+    SOLITAIRE_COUNT(SEARCH_NODES, 1);
+    if (++nodes % kCheckInterval == 0
+        && (stopping || chrono::steady_clock::now() > deadline)) {
+      aborted = true;
+    }
+    if (aborted) {
+      return value;
+    }
+
+    // counting sort into the order to try the moves in, dropping the ones
+    // that can never help
+    MoveBuffer moves;
+    board.GenerateMoves(moves);
+    int ranks[kMaxMoves];
+    int starts[kNumPriorities + 1] = { };
+    for (int i = 0; i < moves.Size(); i++) {
+      int priority = PriorityOf(board, moves[i]);
+      ranks[i] = priority < 0 ? -1 : kTryOrder[priority];
+      if (ranks[i] >= 0) {
+        starts[ranks[i] + 1]++;
+      }
+    }
+    for (int rank = 0; rank < kNumPriorities; rank++) {
+      starts[rank + 1] += starts[rank];
+    }
+    int numOrdered = starts[kNumPriorities];
+    SOLITAIRE_COUNT(PRUNED_MOVES, moves.Size() - numOrdered);
+    Move ordered[kMaxMoves];
+    for (int i = 0; i < moves.Size(); i++) {
+      if (ranks[i] >= 0) {
+        ordered[starts[ranks[i]]++] = moves[i];
+      }
+    }
+
+    for (int i = 0; i < numOrdered; i++) {
+      Move move = ordered[i];
+      UndoRecord played;
+      board.ApplyMove<kDrawCount>(move, played);
+      int child = kNoValue;
+      if (played.turnedOver || board.CanAutoComplete()
+          || (move.type == Move::Type::NEW_TALON
+              && ShowsUnseen(board, seenCards))) {
+        child = ValueOf(board, ply + 1);
+      } else if (Visit(board.SymmetricHash(), depth - 1)) {
+        child = Search<kDrawCount>(board, depth - 1, ply + 1, nullptr);
+      } else {
+        SOLITAIRE_COUNT(TRANSPOSITION_HITS, 1);
+      }
+      board.Undo(played);
+      if (aborted) {
+        return value;
+      }
+      if (child > value) {
+        value = child;
+        if (bestMove != nullptr) {
+          *bestMove = move;
+        }
+      }
+    }
+    return value;
+  }
+}
@@ -0,0 +1,127 @@
+/**
+ * @file hint.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Looks for the best move of a position in the background.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * HintSearch looks for the best move of a position on a background thread.
+   * It searches one move deeper at a time until it runs out of time or is
+   * stopped, so the best move found so far can be asked for at any moment.
+   *
+   * The search only uses what the player can see. A move that turns over a
+   * face-down card ends a line, since the card it shows is not known yet, and
+   * so does a new talon that flips a stock card not yet flipped in the pass
+   * the position is in.
+   * Lines are judged by the cards on the foundation, the cards left face
+   * down and the cards left in the stock and talon.
+   */
+  class HintSearch {
+  private:
+    /**
+     * A position already searched in the current iteration, to the given
+     * depth.
+     */
+    struct Entry {
+      std::uint64_t hash;
+      std::uint8_t depth;
+      std::uint8_t generation;
+    };
+
+    double seconds;
+    std::vector<Entry> table;
+    std::uint8_t generation;
+    std::uint64_t nodes;
+    std::chrono::steady_clock::time_point deadline;
+    bool aborted;
+
+    /**
+     * Whether the current iteration stopped a line at its depth limit.
+     */
+    bool cutOff;
+
+    PackedBoard root;
+
+    /**
+     * The stock and talon cards the player has seen at the root, as a mask
+     * with the bit of each card code set.
+     */
+    std::uint64_t seenCards;
+
+    bool started;
+    std::thread thread;
+    std::atomic<bool> stopping;
+
+    mutable std::mutex mutex;
+    bool found;
+    Move best;
+    int bestDepth;
+
+    /**
+     * Deepens the search from the root until it is stopped, runs out of time
+     * or has nothing deeper to find.
+     */
+    void Run();
+
+    /**
+     * Returns the value of the best line of at most depth moves from the
+     * position, which is ply moves from the root, and fills in the first move
+     * of that line if asked to. Sets aborted if the search had to stop.
+     * Plays moves with the board's methods for the draw count kDrawCount.
+     */
+    template <int kDrawCount>
+    int Search(PackedBoard& board, int depth, int ply, Move* bestMove);
+
+    /**
+     * Records that the position is searched to the depth. Returns false if it
+     * already was, at least that deep, in this iteration.
+     */
+    bool Visit(std::uint64_t hash, int depth);
+
+  public:
+    /**
+     * The time and memory a search may take, by default.
+     */
+    static constexpr double kDefaultSeconds = 10;
+    static const std::size_t kDefaultMegabytes = 16;
+
+    /**
+     * Creates a search that spends at most seconds on a position and keeps
+     * at most megabytes of positions already searched.
+     */
+    explicit HintSearch(double seconds = kDefaultSeconds,
+                        std::size_t megabytes = kDefaultMegabytes);
+    ~HintSearch();
+
+    HintSearch(const HintSearch&) = delete;
+    HintSearch& operator=(const HintSearch&) = delete;
+
+    /**
+     * Starts searching the position in the background, stopping any search of
+     * another position. Does nothing if the position is the one already being
+     * searched, or already searched.
+     */
+    void Start(const PackedBoard& position);
+
+    /**
+     * Stops the search and waits for it to end.
+     */
+    void Stop();
+
+    /**
+     * Fills in the best move found so far and the number of moves the search
+     * looked ahead to find it. Returns false if no move was found yet.
+     */
+    bool GetBest(Move& move, int& depth) const;
+  };
+}
@@ -0,0 +1,97 @@
+/**
+ * @file move.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A compact description of one play on a Solitaire board.
+ */
+#include "move.h"
+
+namespace solitaire {
+  using namespace std;
+
+  void Move::Print(ostream& out) const {
+    switch (type) {
+    case Type::NEW_TALON:
+      out << "draw";
+      break;
+    case Type::TALON_TO_FOUNDATION:
+      out << "wf";
+      break;
+    case Type::TABLEAU_TO_FOUNDATION:
+      out << "t" << int(from) << "f";
+      break;
+    case Type::TALON_TO_TABLEAU:
+      out << "w>" << int(to);
+      break;
+    case Type::FOUNDATION_TO_TABLEAU:
+      out << "f" << int(from) << ">" << int(to);
+      break;
+    case Type::TABLEAU_TO_TABLEAU:
+      out << "t" << int(from) << ">" << int(to);
+      break;
+    default: // only a corrupt move, which the tools that read one report
+      out << "?" << static_cast<int>(type) << ":" << int(from) << ":"
+          << int(to);
+      break;
+    }
+  }
+
+  /**
+   * Reads the index of a pile off the front of the text.
+   */
+  static bool TakeIndex(string_view& text, uint8_t& index) {
+    size_t length = 0;
+    int value = 0;
+    while (length < text.size() && text[length] >= '0'
+           && text[length] <= '9') {
+      value = value * 10 + (text[length++] - '0');
+      if (value > UINT8_MAX) {
+        return false;
+      }
+    }
+    text.remove_prefix(length);
+    index = value;
+    return length > 0;
+  }
+
+  /**
+   * Reads the character off the front of the text if it is there.
+   */
+  static bool Take(string_view& text, char c) {
+    if (text.empty() || text[0] != c) {
+      return false;
+    }
+    text.remove_prefix(1);
+    return true;
+  }
+
+  bool Move::Parse(string_view text, Move& move) {
+    move = { Type::NEW_TALON, 0, 0, 0 };
+    if (text == "draw") {
+      return true;
+    }
+    if (Take(text, 'w')) {
+      if (Take(text, 'f')) {
+        move.type = Type::TALON_TO_FOUNDATION;
+      } else if (Take(text, '>') && TakeIndex(text, move.to)) {
+        move.type = Type::TALON_TO_TABLEAU;
+      } else {
+        return false;
+      }
+    } else if (Take(text, 't') && TakeIndex(text, move.from)) {
+      if (Take(text, 'f')) {
+        move.type = Type::TABLEAU_TO_FOUNDATION;
+      } else if (Take(text, '>') && TakeIndex(text, move.to)) {
+        move.type = Type::TABLEAU_TO_TABLEAU;
+      } else {
+        return false;
+      }
+    } else if (Take(text, 'f') && TakeIndex(text, move.from) && Take(text, '>')
+               && TakeIndex(text, move.to)) {
+      move.type = Type::FOUNDATION_TO_TABLEAU;
+    } else {
+      return false;
+    }
+    return text.empty();
+  }
+}
@@ -0,0 +1,83 @@
+/**
+ * @file move.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A compact description of one play on a Solitaire board.
+ */
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <ostream>
+#include <string_view>
+
+namespace solitaire {
+  /**
+   * Move names one of the plays made by the Board::Do* methods, along with the
+   * piles it touches.
+   */
+  struct Move {
+    enum class Type : std::uint8_t { NEW_TALON, TALON_TO_FOUNDATION,
+        TABLEAU_TO_FOUNDATION, TALON_TO_TABLEAU, FOUNDATION_TO_TABLEAU,
+        TABLEAU_TO_TABLEAU };
+
+    Type type;
+
+    /**
+     * The index of the source tableau or foundation pile, if any.
+     */
+    std::uint8_t from;
+
+    /**
+     * The index of the destination tableau or foundation pile, if any.
+     */
+    std::uint8_t to;
+
+    /**
+     * The number of cards moved.
+     */
+    std::uint8_t count;
+
+    /**
+     * Prints the move in the short notation used by the command-line tools:
+     * "draw", "wf", "w>4", "t2f", "t3>5" and "f1>4", where w is the talon and
+     * t and f are the tableau and foundation piles. A move of no known type
+     * prints as "?", its type number, ":", from, ":" and to.
+     */
+    void Print(std::ostream& out = std::cout) const;
+
+    /**
+     * Reads a move in the notation Print prints. Returns false if the text is
+     * not exactly one move. Pile indices are not checked against the board.
+     */
+    static bool Parse(std::string_view text, Move& move);
+  };
+
+  /**
+   * UndoRecord holds what a played move changed, which is enough to take the
+   * move back without copying the board.
+   */
+  struct UndoRecord {
+    /**
+     * The move as played, naming the foundation pile it used and the number
+     * of cards it moved.
+     */
+    Move move;
+
+    /**
+     * Whether the move turned over the card under the source tableau pile's
+     * face-up cards.
+     */
+    bool turnedOver;
+
+    /**
+     * The talon and stock cursors before the move, as indices into the deck.
+     */
+    std::uint8_t talon;
+    std::uint8_t stock;
+
+    /**
+     * The status of the game before the move.
+     */
+    std::uint8_t status;
+  };
+}
@@ -0,0 +1,321 @@
+/**
+ * @file notation.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A plain-text notation for cards, deals and positions.
+ */
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include "notation.h"
+#include "solitaire.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * The names of the statuses, in the order of Board::Status.
+   */
+  static const string_view kStatusNames[] = { "stuck", "playing", "won" };
+
+  /**
+   * The number of sections of a position: the header, the deck, the
+   * foundations and the tableau piles.
+   */
+  static const int kNumSections = 3 + kTableauSize;
+
+  /**
+   * Splits the first token off the text. Returns false if there is none.
+   */
+  static bool NextToken(string_view& text, string_view& token) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == string_view::npos) {
+      text = string_view();
+      return false;
+    }
+    size_t end = min(text.find_first_of(" \t\r\n", begin), text.size());
+    token = text.substr(begin, end - begin);
+    text.remove_prefix(end);
+    return true;
+  }
+
+  /**
+   * Returns true if nothing but spaces is left of the text.
+   */
+  static bool AtEnd(string_view text) {
+    string_view token;
+    return !NextToken(text, token);
+  }
+
+  /**
+   * Reads a number that is the whole token.
+   */
+  static bool ParseNumber(string_view token, int& number) {
+    const char* end = token.data() + token.size();
+    from_chars_result result = from_chars(token.data(), end, number);
+    return result.ec == errc() && result.ptr == end;
+  }
+
+  /**
+   * Reads a card that is the whole token and marks it as seen. Returns false
+   * if it is not a card or was seen before.
+   */
+  static bool TakeCard(string_view token, bool* seen, CardCode& card) {
+    if (!ParseCard(token, card) || seen[card]) {
+      return false;
+    }
+    seen[card] = true;
+    return true;
+  }
+
+  static char* Append(string_view text, char* out) {
+    memcpy(out, text.data(), text.size());
+    return out + text.size();
+  }
+
+  static char* AppendNumber(int number, char* out) {
+    return to_chars(out, out + 16, number).ptr;
+  }
+
+  string_view StringOf(Board::Status status) {
+    return kStatusNames[static_cast<int>(status)];
+  }
+
+  char* FormatCard(CardCode card, char* out) {
+    *out++ = kRankLetters[card % kNumRanks];
+    *out++ = kSuitLetters[card / kNumRanks];
+    return out;
+  }
+
+  bool ParseCard(string_view text, CardCode& card) {
+    if (text.size() != kCardTextSize) {
+      return false;
+    }
+    size_t rank = string_view(kRankLetters).find(text[0]);
+    size_t suit = string_view(kSuitLetters).find(text[1]);
+    if (rank == string_view::npos || suit == string_view::npos) {
+      return false;
+    }
+    card = suit * kNumRanks + rank;
+    return true;
+  }
+
+  char* FormatDeal(const CardCode* cards, char* out) {
+    for (int i = 0; i < kDeckSize; i++) {
+      if (i > 0) {
+        *out++ = ' ';
+      }
+      out = FormatCard(cards[i], out);
+    }
+    return out;
+  }
+
+  bool ParseDeal(string_view text, CardCode* cards) {
+    bool seen[kDeckSize] = { };
+    string_view token;
+    for (int i = 0; i < kDeckSize; i++) {
+      if (!NextToken(text, token) || !TakeCard(token, seen, cards[i])) {
+        return false;
+      }
+    }
+    return AtEnd(text);
+  }
+
+  char* FormatPosition(const PackedBoard& board, char* out) {
+    out = AppendNumber(board.numOpenCards, out);
+    *out++ = ' ';
+    out = Append(StringOf(static_cast<Board::Status>(board.status)), out);
+    *out++ = ' ';
+    out = AppendNumber(board.stock, out);
+    *out++ = ' ';
+    out = AppendNumber(board.talon, out);
+
+    out = Append(" :", out);
+    for (int i = 0; i < board.deckSize; i++) {
+      *out++ = ' ';
+      out = FormatCard(board.deck[i], out);
+    }
+
+    out = Append(" :", out);
+    for (int i = 0; i < kNumSuits; i++) {
+      *out++ = ' ';
+      out = board.foundation[i] == kNoCard ? Append("--", out)
+        : FormatCard(board.foundation[i], out);
+    }
+
+    for (int i = 0; i < kTableauSize; i++) {
+      out = Append(" :", out);
+      for (int j = 0; j < board.tableauSize[i]; j++) {
+        if (j == board.tableauShown[i]) {
+          out = Append(" |", out);
+        }
+        *out++ = ' ';
+        out = FormatCard(board.tableau[i][j], out);
+      }
+    }
+    return out;
+  }
+
+  /**
+   * Reads the header of a position: the draw, the status and the cursors.
+   */
+  static bool ParseHeader(string_view text, PackedBoard& board,
+                          int& stock, int& talon) {
+    string_view token;
+    int numOpenCards;
+    if (!NextToken(text, token) || !ParseNumber(token, numOpenCards)
+        || (numOpenCards != kOneCardGame && numOpenCards != kThreeCardGame)
+        || !NextToken(text, token)) {
+      return false;
+    }
+    board.numOpenCards = numOpenCards;
+
+    const string_view* status = find(begin(kStatusNames), end(kStatusNames),
+                                     token);
+    if (status == end(kStatusNames)) {
+      return false;
+    }
+    board.status = status - begin(kStatusNames);
+
+    return NextToken(text, token) && ParseNumber(token, stock)
+      && NextToken(text, token) && ParseNumber(token, talon) && AtEnd(text);
+  }
+
+  /**
+   * Reads the cards of the stock and talon.
+   */
+  static bool ParseDeck(string_view text, bool* seen, PackedBoard& board) {
+    string_view token;
+    board.deckSize = 0;
+    while (NextToken(text, token)) {
+      if (board.deckSize == kMaxDeckSize
+          || !TakeCard(token, seen, board.deck[board.deckSize])) {
+        return false;
+      }
+      board.deckSize++;
+    }
+    fill(board.deck + board.deckSize, board.deck + kMaxDeckSize, kNoCard);
+    return true;
+  }
+
+  /**
+   * Reads the top card of each foundation pile and marks the cards under it
+   * as seen too.
+   */
+  static bool ParseFoundation(string_view text, bool* seen,
+                              PackedBoard& board) {
+    string_view token;
+    for (int i = 0; i < kNumSuits; i++) {
+      if (!NextToken(text, token)) {
+        return false;
+      }
+      board.foundation[i] = kNoCard;
+      if (token == "--") {
+        continue;
+      }
+      CardCode top;
+      if (!ParseCard(token, top)) {
+        return false;
+      }
+      for (CardCode card = top - top % kNumRanks; card <= top; card++) {
+        if (seen[card]) {
+          return false;
+        }
+        seen[card] = true;
+      }
+      board.foundation[i] = top;
+    }
+    return AtEnd(text);
+  }
+
+  /**
+   * Returns true if each card after the first is one rank below the card
+   * before it and of the other color, as the face-up cards of a tableau pile
+   * always are.
+   */
+  static bool IsRun(const CardCode* cards, int count) {
+    for (int i = 1; i < count; i++) {
+      // suits alternate in color, so the parity of the suit is the color
+      if (cards[i] % kNumRanks + 1 != cards[i - 1] % kNumRanks
+          || cards[i] / kNumRanks % 2 == cards[i - 1] / kNumRanks % 2) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Reads a tableau pile. A pile that is not empty must have a face-up card,
+   * and its face-up cards must be a run.
+   */
+  static bool ParsePile(string_view text, bool* seen, int pileIdx,
+                        PackedBoard& board) {
+    string_view token;
+    CardCode* pile = board.tableau[pileIdx];
+    int size = 0;
+    int shown = -1;
+    while (NextToken(text, token)) {
+      if (token == "|") {
+        if (shown >= 0) {
+          return false;
+        }
+        shown = size;
+      } else if (size == kMaxTableauPileSize
+                 || !TakeCard(token, seen, pile[size++])) {
+        return false;
+      }
+    }
+    if (size == 0 ? shown >= 0
+        : shown < 0 || shown == size || !IsRun(pile + shown, size - shown)) {
+      return false;
+    }
+    fill(pile + size, pile + kMaxTableauPileSize, kNoCard);
+    board.tableauSize[pileIdx] = size;
+    board.tableauShown[pileIdx] = size == 0 ? 0 : shown;
+    return true;
+  }
+
+  bool ParsePosition(string_view text, PackedBoard& board) {
+    string_view sections[kNumSections];
+    for (int i = 0; i < kNumSections; i++) {
+      size_t end = text.find(':');
+      if ((end == string_view::npos) != (i == kNumSections - 1)) {
+        return false;
+      }
+      sections[i] = text.substr(0, end);
+      text.remove_prefix(min(end + 1, text.size()));
+    }
+
+    bool seen[kDeckSize] = { };
+    int stock;
+    int talon;
+    if (!ParseHeader(sections[0], board, stock, talon)
+        || !ParseDeck(sections[1], seen, board)
+        || !ParseFoundation(sections[2], seen, board)) {
+      return false;
+    }
+    board.numFaceDown = 0;
+    for (int i = 0; i < kTableauSize; i++) {
+      if (!ParsePile(sections[3 + i], seen, i, board)) {
+        return false;
+      }
+      board.numFaceDown += board.tableauShown[i];
+    }
+
+    // the talon, when it is not empty, ends at the card under the stock and
+    // shows at most one draw of cards; play only empties it at the end of a
+    // pass, with the stock back at the start of the deck
+    if (stock < 0 || stock > board.deckSize || talon < 0
+        || talon > board.deckSize
+        || (talon == board.deckSize && stock != 0)
+        || (talon != board.deckSize
+            && (talon >= stock || stock - talon > board.numOpenCards))
+        || find(seen, seen + kDeckSize, false) != seen + kDeckSize) {
+      return false;
+    }
+    board.stock = stock;
+    board.talon = talon;
+    board.ResetHashes();
+    return true;
+  }
+}
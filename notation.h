@@ -0,0 +1,99 @@
+/**
+ * @file notation.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A plain-text notation for cards, deals and positions.
+ *
+ * A card is written as its rank, one of A 2-9 T J Q K, then its suit, one of
+ * s h c d, such as "As", "Th" or "9c". A deal is its kDeckSize cards in the
+ * order PackedBoard::Deal lays them out, separated by spaces. A position is
+ *
+ *     <draw> <status> <stock> <talon> : <deck> : <foundations> : <pile 0>
+ *       : ... : <pile 6>
+ *
+ * on one line, where the draw is the number of cards flipped at a time, the
+ * status is playing, stuck or won, the stock and talon are the cursors of
+ * PackedBoard, the deck is the cards of the stock and talon, the foundations
+ * are the top card of each foundation pile or "--" if it is empty, and each
+ * pile lists its face-down cards, then "|", then its face-up cards. An empty
+ * pile is written as nothing. The draw must be 1 or 3, and the face-up cards
+ * of a pile must go down in rank one at a time, alternating in color, as play
+ * keeps them. So must the cursors: an empty talon, whose cursor is the deck
+ * size, has the stock at 0, and any other talon ends at the card under the
+ * stock and holds at most draw cards.
+ *
+ * The formatters write into a buffer the caller provides and the parsers
+ * read from a string_view, so neither ever allocates.
+ */
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * The letters of the ranks, from ace to king.
+   */
+  inline constexpr char kRankLetters[] = "A23456789TJQK";
+
+  /**
+   * The letters of the suits, in the order of the suit enum.
+   */
+  inline constexpr char kSuitLetters[] = "shcd";
+
+  /**
+   * The number of characters of a card.
+   */
+  const std::size_t kCardTextSize = 2;
+
+  /**
+   * The number of characters of a deal.
+   */
+  const std::size_t kDealTextSize = kDeckSize * (kCardTextSize + 1) - 1;
+
+  /**
+   * Room for any position.
+   */
+  const std::size_t kMaxPositionTextSize = 256;
+
+  /**
+   * Returns the name of the status: stuck, playing or won.
+   */
+  std::string_view StringOf(Board::Status status);
+
+  /**
+   * Writes the card, which must not be kNoCard, to the buffer. Returns the end
+   * of what was written.
+   */
+  char* FormatCard(CardCode card, char* out);
+
+  /**
+   * Reads a card. Returns false if the text is not exactly one card.
+   */
+  bool ParseCard(std::string_view text, CardCode& card);
+
+  /**
+   * Writes the kDeckSize cards to a buffer of at least kDealTextSize
+   * characters. Returns the end of what was written.
+   */
+  char* FormatDeal(const CardCode* cards, char* out);
+
+  /**
+   * Reads kDeckSize cards. Returns false if the text is not every card of the
+   * deck exactly once.
+   */
+  bool ParseDeal(std::string_view text, CardCode* cards);
+
+  /**
+   * Writes the position to a buffer of at least kMaxPositionTextSize
+   * characters. Returns the end of what was written.
+   */
+  char* FormatPosition(const PackedBoard& board, char* out);
+
+  /**
+   * Reads a position and computes its hash. Returns false and leaves the board
+   * in an unspecified state if the text is not a position as described above
+   * in which every card of the deck appears exactly once.
+   */
+  bool ParsePosition(std::string_view text, PackedBoard& board);
+}
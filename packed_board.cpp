@@ -0,0 +1,745 @@
+/**
+ * @file packed_board.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A compact, fixed-size copy of a Solitaire board.
+ */
+#include <algorithm>
+#include <cstring>
+#include "deal.h"
+#include "packed_board.h"
+#include "stats.h"
+#include "zobrist.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * Returns the rank of the card counting from 0 for an ace.
+   */
+  static inline int RankOf(CardCode code) {
+    return code % kNumRanks;
+  }
+
+  /**
+   * Returns 0 for a black card and 1 for a red card.
+   */
+  static inline int ColorOf(CardCode code) {
+    return code / kNumRanks % 2;
+  }
+
+  /**
+   * Returns true if the second card can be built down under the first card in
+   * the tableau pile; otherwise, returns false.
+   */
+  static inline bool CanBuildDown(CardCode kingHigh, CardCode aceLow) {
+    return RankOf(aceLow) + 1 == RankOf(kingHigh)
+      && ColorOf(kingHigh) != ColorOf(aceLow);
+  }
+
+  /**
+   * Returns true if the card can be built down on a tableau pile whose last
+   * card is given, or which is empty if it is kNoCard.
+   */
+  static inline bool CanBuildDownOn(CardCode card, CardCode last) {
+    if (last == kNoCard) {
+      return RankOf(card) == kNumRanks - 1;
+    }
+    return CanBuildDown(last, card);
+  }
+
+  /**
+   * Returns true if the card can be built up on a foundation pile whose top
+   * card is given, or which is empty if it is kNoCard.
+   */
+  static inline bool CanBuildUpOn(CardCode card, CardCode top) {
+    if (top == kNoCard) {
+      return RankOf(card) == 0;
+    }
+    return card == top + 1 && RankOf(card) != 0;
+  }
+
+  /**
+   * Returns the last card of a tableau pile, or kNoCard if it is empty.
+   */
+  static inline CardCode LastOf(const PackedBoard& board, int tableauIdx) {
+    int size = board.tableauSize[tableauIdx];
+    return size == 0 ? kNoCard : board.tableau[tableauIdx][size - 1];
+  }
+
+  /**
+   * Returns the index of the first foundation pile that takes the card, or -1
+   * if there is none.
+   */
+  static inline int FoundationFor(const PackedBoard& board, CardCode card) {
+    for (int i = 0; i < kNumSuits; i++) {
+      if (CanBuildUpOn(card, board.foundation[i])) {
+        return i;
+      }
+    }
+    return -1;
+  }
+
+  /**
+   * Returns the mask with the bit of each card code of the rank set.
+   */
+  static inline uint64_t CardsOfRank(int rank) {
+    uint64_t mask = 0;
+    for (int suit = 0; suit < kNumSuits; suit++) {
+      mask |= uint64_t(1) << (suit * kNumRanks + rank);
+    }
+    return mask;
+  }
+
+  /**
+   * Returns true if the card can go to the foundation with nothing lost: it
+   * is an ace or a two, or the foundation holds both cards of the other color
+   * one rank lower, given the number of cards of each suit on it.
+   */
+  static inline bool SafeToFoundation(CardCode card,
+                                      const int homeCounts[kNumSuits]) {
+    int rank = RankOf(card);
+    int suit = card / kNumRanks;
+    // the suits alternate in color, so the neighbours are of the other one
+    return rank <= 1 || (homeCounts[(suit + 1) % kNumSuits] >= rank
+                         && homeCounts[(suit + 3) % kNumSuits] >= rank);
+  }
+
+  /**
+   * Returns the index of the face-up card of the source pile that can be built
+   * down on the destination pile, or -1 if there is none. The face-up cards of
+   * a pile always form a run, so the only candidate is found from the ranks.
+   */
+  static inline int TableauSourceFor(const PackedBoard& board, int fromIdx,
+                                     int toIdx) {
+    int shown = board.tableauShown[fromIdx];
+    int size = board.tableauSize[fromIdx];
+    if (size == 0) {
+      return -1;
+    }
+    CardCode last = LastOf(board, toIdx);
+    int highRank = RankOf(board.tableau[fromIdx][shown]);
+    int wantedRank = last == kNoCard ? kNumRanks - 1 : RankOf(last) - 1;
+    int position = shown + highRank - wantedRank;
+    if (position < shown || position >= size
+        || !CanBuildDownOn(board.tableau[fromIdx][position], last)) {
+      return -1;
+    }
+    return position;
+  }
+
+  /**
+   * Returns the key of a tableau card in the symmetric hash.
+   */
+  static inline uint64_t SymmetricTableauKey(const CardCode* pile,
+                                             int index) {
+    return OnKey(pile[index], index == 0 ? kNoCard : pile[index - 1]);
+  }
+
+  /**
+   * Returns the key of a tableau pile's first face-up card in the symmetric
+   * hash, which an empty pile does not have.
+   */
+  static inline uint64_t SymmetricShownKey(const PackedBoard& board,
+                                           int tableauIdx) {
+    int shown = board.tableauShown[tableauIdx];
+    return shown < board.tableauSize[tableauIdx]
+      ? ShownCardKey(board.tableau[tableauIdx][shown]) : 0;
+  }
+
+  /**
+   * Removes the cards from position to the end of a tableau pile, turning
+   * over the new last card if needed. Returns true if it turned over a card.
+   */
+  static inline bool EraseFrom(PackedBoard& board, int tableauIdx,
+                               int position) {
+    CardCode* pile = board.tableau[tableauIdx];
+    bool turnsOver = position <= board.tableauShown[tableauIdx];
+    uint64_t delta = turnsOver ? SymmetricShownKey(board, tableauIdx) : 0;
+    for (int i = position; i < board.tableauSize[tableauIdx]; i++) {
+      uint64_t key = TableauKey(tableauIdx, i, pile[i]);
+      board.hash ^= key;
+      delta ^= key ^ SymmetricTableauKey(pile, i);
+    }
+    fill(pile + position, pile + board.tableauSize[tableauIdx], kNoCard);
+    board.tableauSize[tableauIdx] = position;
+    if (turnsOver) {
+      int shown = position == 0 ? 0 : position - 1;
+      uint64_t key = ShownKey(tableauIdx, board.tableauShown[tableauIdx])
+        ^ ShownKey(tableauIdx, shown);
+      board.hash ^= key;
+      board.numFaceDown -= board.tableauShown[tableauIdx] - shown;
+      board.tableauShown[tableauIdx] = shown;
+      delta ^= key ^ SymmetricShownKey(board, tableauIdx);
+    }
+    board.symmetricDelta ^= delta;
+    return turnsOver;
+  }
+
+  /**
+   * Turns the cards of a tableau pile from position to the end face up and
+   * the rest face down, which takes back EraseFrom turning over a card.
+   */
+  static inline void ShowFrom(PackedBoard& board, int tableauIdx,
+                              int position) {
+    uint64_t key = ShownKey(tableauIdx, board.tableauShown[tableauIdx])
+      ^ ShownKey(tableauIdx, position);
+    uint64_t delta = key ^ SymmetricShownKey(board, tableauIdx);
+    board.hash ^= key;
+    board.numFaceDown += position - board.tableauShown[tableauIdx];
+    board.tableauShown[tableauIdx] = position;
+    board.symmetricDelta ^= delta ^ SymmetricShownKey(board, tableauIdx);
+  }
+
+  /**
+   * Appends the cards to a tableau pile. Only on an empty pile does that
+   * change which card is the first face up.
+   */
+  static inline void Append(PackedBoard& board, int tableauIdx,
+                            const CardCode* cards, int count) {
+    CardCode* pile = board.tableau[tableauIdx];
+    int size = board.tableauSize[tableauIdx];
+    memcpy(pile + size, cards, count);
+    board.tableauSize[tableauIdx] = size + count;
+    uint64_t delta = size == 0 ? ShownCardKey(cards[0]) : 0;
+    for (int i = size; i < size + count; i++) {
+      uint64_t key = TableauKey(tableauIdx, i, pile[i]);
+      board.hash ^= key;
+      delta ^= key ^ SymmetricTableauKey(pile, i);
+    }
+    board.symmetricDelta ^= delta;
+  }
+
+  /**
+   * Returns the part of the hash that covers the stock and talon cursors.
+   */
+  static inline uint64_t CursorHash(const PackedBoard& board) {
+    if (board.TalonEmpty()) {
+      return CursorKey(kNoCard, kNoCard);
+    }
+    return CursorKey(board.TalonCard(), board.deck[board.talon]);
+  }
+
+  /**
+   * Replaces the top card of a foundation pile.
+   */
+  static inline void SetFoundation(PackedBoard& board, int foundationIdx,
+                                   CardCode top) {
+    CardCode old = board.foundation[foundationIdx];
+    uint64_t key = FoundationKey(foundationIdx, old)
+      ^ FoundationKey(foundationIdx, top);
+    board.hash ^= key;
+    board.symmetricDelta ^= key ^ SuitTopKey(old) ^ SuitTopKey(top);
+    board.foundation[foundationIdx] = top;
+  }
+
+  /**
+   * Removes the accessible card from the talon, keeping the talon in the same
+   * place the way Board does.
+   */
+  static inline void EraseTalonCard(PackedBoard& board) {
+    int position = board.stock - 1;
+    board.hash ^= CursorHash(board) ^ DeckKey(board.deck[position]);
+    if (position == board.talon) {
+      board.talon = position == 0 ? board.deckSize - 1 : position - 1;
+    }
+    memmove(board.deck + position, board.deck + position + 1,
+            board.deckSize - position - 1);
+    board.deck[--board.deckSize] = kNoCard;
+    board.stock--;
+    board.hash ^= CursorHash(board);
+  }
+
+  /**
+   * Puts a card taken from the talon back where it was and restores the
+   * cursors from before the move.
+   */
+  static inline void InsertTalonCard(PackedBoard& board, CardCode card,
+                                     const UndoRecord& record) {
+    int position = record.stock - 1;
+    board.hash ^= CursorHash(board) ^ DeckKey(card);
+    memmove(board.deck + position + 1, board.deck + position,
+            board.deckSize - position);
+    board.deck[position] = card;
+    board.deckSize++;
+    board.talon = record.talon;
+    board.stock = record.stock;
+    board.hash ^= CursorHash(board);
+  }
+
+  void PackedBoard::Deal(uint64_t dealNumber, int numOpenCards) {
+    CardCode cards[kDeckSize];
+    ShuffleDeal(dealNumber, cards);
+    Deal(cards, numOpenCards);
+  }
+
+  void PackedBoard::Deal(const CardCode* cards, int numOpenCards) {
+    this->numOpenCards = numOpenCards;
+    status = static_cast<uint8_t>(Board::Status::PLAYING);
+
+    // make the tableau
+    const CardCode* it = cards;
+    numFaceDown = 0;
+    for (int i = 0; i < kTableauSize; i++) {
+      memcpy(tableau[i], it, i + 1);
+      fill(tableau[i] + i + 1, tableau[i] + kMaxTableauPileSize, kNoCard);
+      tableauSize[i] = i + 1;
+      tableauShown[i] = i;
+      numFaceDown += i;
+      it += i + 1;
+    }
+    fill(foundation, foundation + kNumSuits, kNoCard);
+
+    // make the stock cards
+    memcpy(deck, it, kMaxDeckSize);
+    deckSize = kMaxDeckSize;
+    stock = 0;
+    talon = deckSize;
+    ResetHashes();
+  }
+
+  bool PackedBoard::IsWon() const {
+    for (int i = 0; i < kNumSuits; i++) {
+      if (foundation[i] == kNoCard || RankOf(foundation[i]) != kNumRanks - 1) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void PackedBoard::GenerateMoves(MoveBuffer& moves) const {
+    moves.Clear();
+
+    // moves to the foundation...
+    if (!TalonEmpty()) {
+      int foundationIdx = FoundationFor(*this, TalonCard());
+      if (foundationIdx >= 0) {
+        moves.PushBack({ Move::Type::TALON_TO_FOUNDATION, 0,
+              uint8_t(foundationIdx), 1 });
+      }
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      if (tableauSize[i] == 0) {
+        continue;
+      }
+      int foundationIdx = FoundationFor(*this, LastOf(*this, i));
+      if (foundationIdx >= 0) {
+        moves.PushBack({ Move::Type::TABLEAU_TO_FOUNDATION, uint8_t(i),
+              uint8_t(foundationIdx), 1 });
+      }
+    }
+
+    // moves to the tableau...
+    for (int to = 0; to < kTableauSize; to++) {
+      for (int from = 0; from < kTableauSize; from++) {
+        if (from == to) {
+          continue;
+        }
+        int position = TableauSourceFor(*this, from, to);
+        if (position >= 0) {
+          moves.PushBack({ Move::Type::TABLEAU_TO_TABLEAU, uint8_t(from),
+                uint8_t(to), uint8_t(tableauSize[from] - position) });
+        }
+      }
+    }
+    if (!TalonEmpty()) {
+      for (int to = 0; to < kTableauSize; to++) {
+        if (CanBuildDownOn(TalonCard(), LastOf(*this, to))) {
+          moves.PushBack({ Move::Type::TALON_TO_TABLEAU, 0, uint8_t(to), 1 });
+        }
+      }
+    }
+    for (int from = 0; from < kNumSuits; from++) {
+      if (foundation[from] == kNoCard) {
+        continue;
+      }
+      for (int to = 0; to < kTableauSize; to++) {
+        if (CanBuildDownOn(foundation[from], LastOf(*this, to))) {
+          moves.PushBack({ Move::Type::FOUNDATION_TO_TABLEAU, uint8_t(from),
+                uint8_t(to), 1 });
+        }
+      }
+    }
+
+    if (deckSize > 0) {
+      moves.PushBack({ Move::Type::NEW_TALON, 0, 0, 0 });
+    }
+  }
+
+  /**
+   * Returns the draw count of the position: kDrawCount unless that is
+   * kAnyDrawCount, so that it is a constant the compiler can fold.
+   */
+  template <int kDrawCount>
+  static inline int DrawCountOf(const PackedBoard& board) {
+    return kDrawCount == kAnyDrawCount ? board.numOpenCards : kDrawCount;
+  }
+
+  template <int kDrawCount>
+  void PackedBoard::GenerateMacroMoves(MoveBuffer& moves) const {
+    GenerateMoves(moves);
+    if (deckSize == 0) {
+      return;
+    }
+    moves.PopBack(); // the new talon, which comes last
+
+    // the cards the foundation or the tableau would take, as a mask with the
+    // bit of each card code set
+    uint64_t accepts = 0;
+    for (CardCode top : foundation) {
+      accepts |= top == kNoCard ? CardsOfRank(0) : uint64_t(1) << (top + 1);
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      CardCode last = LastOf(*this, i);
+      if (last == kNoCard) {
+        accepts |= CardsOfRank(kNumRanks - 1);
+      } else if (RankOf(last) > 0) {
+        // the suits alternate in color, so the other color's are next to it
+        int suit = last / kNumRanks;
+        int rank = RankOf(last) - 1;
+        accepts |= uint64_t(1) << (((suit + 1) % kNumSuits) * kNumRanks + rank)
+          | uint64_t(1) << (((suit + 3) % kNumSuits) * kNumRanks + rank);
+      }
+    }
+
+    // walk the stock through the rest of this pass and one whole pass from
+    // the beginning, after which the passes repeat; a card that comes up in
+    // both, or is up now, is the same position both times unless the talon
+    // starts elsewhere, as it can for the last card or once talon cards have
+    // been played
+    int talonOf[kMaxDeckSize];
+    fill(talonOf, talonOf + deckSize, -1);
+    if (!TalonEmpty()) {
+      talonOf[stock - 1] = talon;
+    }
+    const int drawCount = DrawCountOf<kDrawCount>(*this);
+    int newTalon = talon;
+    int newStock = stock;
+    bool startedOver = false;
+    for (int count = 1; /**/; count++) {
+      if (newStock == deckSize) {
+        if (startedOver) {
+          break;
+        }
+        startedOver = true;
+        newTalon = deckSize;
+        newStock = 0;
+        continue;
+      }
+      newTalon = newStock;
+      newStock = min(newStock + drawCount, int(deckSize));
+      int index = newStock - 1;
+      if (talonOf[index] == newTalon) {
+        continue;
+      }
+      talonOf[index] = newTalon;
+
+      if ((accepts & uint64_t(1) << deck[index]) != 0) {
+        moves.PushBack({ Move::Type::NEW_TALON, 0, 0, uint8_t(count) });
+      }
+    }
+  }
+
+  bool PackedBoard::AutoComplete(vector<Move>& moves) {
+    // every card lower than the lowest one left is on the foundation, so
+    // that one is safe to move there once it is on top; a pass through the
+    // stock and back to its start takes at most deckSize + 1 new talons
+    int dealsLeft = deckSize + 1;
+    while (!IsWon()) {
+      Move move;
+      if (FindSafeMove(move)) {
+        dealsLeft = deckSize + 1;
+      } else if (dealsLeft-- > 0) {
+        move = { Move::Type::NEW_TALON, 0, 0, 0 };
+      } else {
+        return false;
+      }
+      if (!ApplyMove(move)) {
+        return false;
+      }
+      moves.push_back(move);
+    }
+    return true;
+  }
+
+  int NewTalonsToReach(int index, int deckSize, int talon, int stock,
+                       int numOpenCards) {
+    if (index == stock - 1 && talon != deckSize) {
+      return 0;
+    }
+    // the new talons after which a pass from the stock at the start shows
+    // the card, or -1 if it does not
+    auto inPass = [&](int start) {
+      if (index < start) {
+        return -1;
+      }
+      if (index == deckSize - 1) {
+        return (deckSize - start + numOpenCards - 1) / numOpenCards;
+      }
+      if ((index + 1 - start) % numOpenCards != 0) {
+        return -1;
+      }
+      return (index + 1 - start) / numOpenCards;
+    };
+    int count = inPass(stock);
+    if (count > 0) {
+      return count;
+    }
+    count = inPass(0);
+    if (count < 0) {
+      return -1;
+    }
+    // finish this pass and start over
+    return (deckSize - stock + numOpenCards - 1) / numOpenCards + 1 + count;
+  }
+
+  bool PackedBoard::FindSafeMove(Move& move) const {
+    int homeCounts[kNumSuits] = { };
+    for (CardCode top : foundation) {
+      if (top != kNoCard) {
+        homeCounts[top / kNumRanks] = RankOf(top) + 1;
+      }
+    }
+
+    if (!TalonEmpty()) {
+      CardCode card = TalonCard();
+      int foundationIdx = FoundationFor(*this, card);
+      if (foundationIdx >= 0 && SafeToFoundation(card, homeCounts)) {
+        move = { Move::Type::TALON_TO_FOUNDATION, 0, uint8_t(foundationIdx),
+                 1 };
+        return true;
+      }
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      if (tableauSize[i] == 0) {
+        continue;
+      }
+      CardCode card = LastOf(*this, i);
+      int foundationIdx = FoundationFor(*this, card);
+      if (foundationIdx >= 0 && SafeToFoundation(card, homeCounts)) {
+        move = { Move::Type::TABLEAU_TO_FOUNDATION, uint8_t(i),
+                 uint8_t(foundationIdx), 1 };
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool PackedBoard::ApplyMove(Move move) {
+    UndoRecord record;
+    return ApplyMove(move, record);
+  }
+
+  template <int kDrawCount>
+  bool PackedBoard::ApplyMove(Move move, UndoRecord& record) {
+    HashCheck<PackedBoard> check(*this);
+    record.move = move;
+    record.turnedOver = false;
+    record.talon = talon;
+    record.stock = stock;
+    record.status = status;
+    switch (move.type) {
+    case Move::Type::NEW_TALON:
+      if (deckSize == 0) {
+        return false;
+      }
+      hash ^= CursorHash(*this);
+      for (int i = 0; i < max(int(move.count), 1); i++) {
+        if (stock == deckSize) { // reached end of the stock
+          talon = deckSize;
+          stock = 0;
+          SOLITAIRE_COUNT(TALON_CYCLES, 1);
+        } else {                 // flip the next cards after the talon
+          talon = stock;
+          stock = min(stock + DrawCountOf<kDrawCount>(*this), int(deckSize));
+        }
+      }
+      hash ^= CursorHash(*this);
+      return true;
+
+    case Move::Type::TALON_TO_FOUNDATION: {
+      if (TalonEmpty()) {
+        return false;
+      }
+      int foundationIdx = FoundationFor(*this, TalonCard());
+      if (foundationIdx < 0) {
+        return false;
+      }
+      SetFoundation(*this, foundationIdx, TalonCard());
+      EraseTalonCard(*this);
+      record.move.to = foundationIdx;
+      return true;
+    }
+    case Move::Type::TABLEAU_TO_FOUNDATION: {
+      if (move.from >= kTableauSize || tableauSize[move.from] == 0) {
+        return false;
+      }
+      CardCode card = LastOf(*this, move.from);
+      int foundationIdx = FoundationFor(*this, card);
+      if (foundationIdx < 0) {
+        return false;
+      }
+      SetFoundation(*this, foundationIdx, card);
+      record.move.to = foundationIdx;
+      record.turnedOver = EraseFrom(*this, move.from,
+                                    tableauSize[move.from] - 1);
+      return true;
+    }
+    case Move::Type::TALON_TO_TABLEAU: {
+      if (move.to >= kTableauSize || TalonEmpty()) {
+        return false;
+      }
+      CardCode card = TalonCard();
+      if (!CanBuildDownOn(card, LastOf(*this, move.to))) {
+        return false;
+      }
+      Append(*this, move.to, &card, 1);
+      EraseTalonCard(*this);
+      return true;
+    }
+    case Move::Type::FOUNDATION_TO_TABLEAU: {
+      if (move.from >= kNumSuits || move.to >= kTableauSize
+          || foundation[move.from] == kNoCard) {
+        return false;
+      }
+      CardCode card = foundation[move.from];
+      if (!CanBuildDownOn(card, LastOf(*this, move.to))) {
+        return false;
+      }
+      Append(*this, move.to, &card, 1);
+      SetFoundation(*this, move.from, RankOf(card) == 0 ? kNoCard : card - 1);
+      return true;
+    }
+    case Move::Type::TABLEAU_TO_TABLEAU: {
+      if (move.from == move.to || move.from >= kTableauSize
+          || move.to >= kTableauSize) {
+        return false;
+      }
+      int position = TableauSourceFor(*this, move.from, move.to);
+      if (position < 0) {
+        return false;
+      }
+      record.move.count = tableauSize[move.from] - position;
+      Append(*this, move.to, tableau[move.from] + position, record.move.count);
+      record.turnedOver = EraseFrom(*this, move.from, position);
+      return true;
+    }
+    default:
+      return false;
+    }
+  }
+
+  void PackedBoard::Undo(const UndoRecord& record) {
+    HashCheck<PackedBoard> check(*this);
+    const Move& move = record.move;
+    switch (move.type) {
+    case Move::Type::NEW_TALON:
+      hash ^= CursorHash(*this);
+      talon = record.talon;
+      stock = record.stock;
+      hash ^= CursorHash(*this);
+      break;
+
+    case Move::Type::TALON_TO_FOUNDATION: {
+      CardCode card = foundation[move.to];
+      SetFoundation(*this, move.to, RankOf(card) == 0 ? kNoCard : card - 1);
+      InsertTalonCard(*this, card, record);
+      break;
+    }
+    case Move::Type::TABLEAU_TO_FOUNDATION: {
+      CardCode card = foundation[move.to];
+      SetFoundation(*this, move.to, RankOf(card) == 0 ? kNoCard : card - 1);
+      Append(*this, move.from, &card, 1);
+      if (record.turnedOver) {
+        ShowFrom(*this, move.from, tableauSize[move.from] - 1);
+      }
+      break;
+    }
+    case Move::Type::TALON_TO_TABLEAU: {
+      CardCode card = LastOf(*this, move.to);
+      EraseFrom(*this, move.to, tableauSize[move.to] - 1);
+      InsertTalonCard(*this, card, record);
+      break;
+    }
+    case Move::Type::FOUNDATION_TO_TABLEAU: {
+      CardCode card = LastOf(*this, move.to);
+      EraseFrom(*this, move.to, tableauSize[move.to] - 1);
+      SetFoundation(*this, move.from, card);
+      break;
+    }
+    case Move::Type::TABLEAU_TO_TABLEAU: {
+      int position = tableauSize[move.to] - move.count;
+      int fromSize = tableauSize[move.from];
+      Append(*this, move.from, tableau[move.to] + position, move.count);
+      EraseFrom(*this, move.to, position);
+      if (record.turnedOver) {
+        ShowFrom(*this, move.from, fromSize);
+      }
+      break;
+    }
+    }
+    status = record.status;
+  }
+
+  uint64_t PackedBoard::ComputeHash() const {
+    uint64_t hash = CursorHash(*this);
+    for (int i = 0; i < deckSize; i++) {
+      hash ^= DeckKey(deck[i]);
+    }
+    for (int i = 0; i < kNumSuits; i++) {
+      hash ^= FoundationKey(i, foundation[i]);
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      for (int j = 0; j < tableauSize[i]; j++) {
+        hash ^= TableauKey(i, j, tableau[i][j]);
+      }
+      hash ^= ShownKey(i, tableauShown[i]);
+    }
+    return hash;
+  }
+
+  uint64_t PackedBoard::ComputeSymmetricHash() const {
+    uint64_t hash = CursorHash(*this);
+    for (int i = 0; i < deckSize; i++) {
+      hash ^= DeckKey(deck[i]);
+    }
+    for (int i = 0; i < kNumSuits; i++) {
+      hash ^= SuitTopKey(foundation[i]);
+    }
+    for (int i = 0; i < kTableauSize; i++) {
+      for (int j = 0; j < tableauSize[i]; j++) {
+        hash ^= SymmetricTableauKey(tableau[i], j);
+      }
+      hash ^= SymmetricShownKey(*this, i);
+    }
+    return hash;
+  }
+
+  void PackedBoard::ResetHashes() {
+    hash = ComputeHash();
+    symmetricDelta = ComputeSymmetricHash() ^ hash;
+  }
+
+  template <int kDrawCount>
+  uint64_t PackedBoard::ProofHash() const {
+    // a pass deals the cards from the start in groups of the draw count
+    const int drawCount = DrawCountOf<kDrawCount>(*this);
+    if (!TalonEmpty() && talon % drawCount == 0
+        && stock == min(talon + drawCount, int(deckSize))) {
+      return SymmetricHash() ^ CursorHash(*this) ^ CursorKey(kNoCard, kNoCard);
+    }
+    return SymmetricHash();
+  }
+
+  // the draw counts WithDrawCount hands out
+  template void PackedBoard::GenerateMacroMoves<kAnyDrawCount>(MoveBuffer&)
+    const;
+  template void PackedBoard::GenerateMacroMoves<1>(MoveBuffer&) const;
+  template void PackedBoard::GenerateMacroMoves<3>(MoveBuffer&) const;
+  template bool PackedBoard::ApplyMove<kAnyDrawCount>(Move, UndoRecord&);
+  template bool PackedBoard::ApplyMove<1>(Move, UndoRecord&);
+  template bool PackedBoard::ApplyMove<3>(Move, UndoRecord&);
+  template uint64_t PackedBoard::ProofHash<kAnyDrawCount>() const;
+  template uint64_t PackedBoard::ProofHash<1>() const;
+  template uint64_t PackedBoard::ProofHash<3>() const;
+}
@@ -0,0 +1,283 @@
+/**
+ * @file packed_board.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A compact, fixed-size copy of a Solitaire board.
+ */
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+#include "board.h"
+
+namespace solitaire {
+  /**
+   * The most cards a tableau pile can hold: six face-down cards under a run
+   * from king to ace.
+   */
+  const int kMaxTableauPileSize = kTableauSize - 1 + kNumRanks;
+
+  /**
+   * The number of cards left over for the stock after dealing the tableau.
+   */
+  const int kMaxDeckSize = kDeckSize - kTableauSize * (kTableauSize + 1) / 2;
+
+  /**
+   * Returns how many new talons make the card at the index of a deck of
+   * deckSize cards the talon card, counting from the given talon and stock
+   * cursors and numOpenCards at a time, or -1 if no number does. The card
+   * now on top of the talon takes 0. Takes constant time: the rest of the
+   * current pass reaches every numOpenCards-th card after the stock, and
+   * each later pass every numOpenCards-th card from the beginning, and the
+   * last card of the deck always.
+   */
+  int NewTalonsToReach(int index, int deckSize, int talon, int stock,
+                       int numOpenCards);
+
+  /**
+   * The draw count of the methods templated on it that take the position's
+   * numOpenCards instead of a number fixed when compiling.
+   */
+  const int kAnyDrawCount = 0;
+
+  /**
+   * PackedBoard stores a board position in one flat block of bytes, one byte
+   * per card. It is a trivially copyable value, so copying a position is a
+   * memcpy, and it takes a small fraction of the memory of a Board, whose
+   * cards each live in their own list node.
+   *
+   * Indices take the place of the Board's list iterators: a past-the-end
+   * iterator is stored as the size of its pile. The stock and talon cursors
+   * are the same indices into the deck that Board keeps.
+   */
+  struct PackedBoard {
+    /**
+     * The Zobrist hash of the position, kept up to date by ApplyMove.
+     */
+    std::uint64_t hash;
+
+    /**
+     * The symmetric hash of the position xor its Zobrist hash, kept up to
+     * date by ApplyMove. The two only differ in how they hash the tableau
+     * and foundation.
+     */
+    std::uint64_t symmetricDelta;
+
+    /**
+     * The number of cards flipped to the talon at a time.
+     */
+    std::uint8_t numOpenCards;
+
+    /**
+     * The Board::Status of the game.
+     */
+    std::uint8_t status;
+
+    /**
+     * The number of cards left in the stock and talon.
+     */
+    std::uint8_t deckSize;
+
+    /**
+     * The index in the deck of the first card not yet flipped to the talon.
+     */
+    std::uint8_t stock;
+
+    /**
+     * The index in the deck of the first talon card on display.
+     */
+    std::uint8_t talon;
+
+    /**
+     * The number of face-down cards in the tableau, kept up to date by
+     * ApplyMove.
+     */
+    std::uint8_t numFaceDown;
+
+    /**
+     * The cards of the stock and talon, in dealing order.
+     */
+    CardCode deck[kMaxDeckSize];
+
+    /**
+     * The top card of each foundation pile, or kNoCard if it is empty.
+     */
+    CardCode foundation[kNumSuits];
+
+    /**
+     * The number of cards in each tableau pile.
+     */
+    std::uint8_t tableauSize[kTableauSize];
+
+    /**
+     * The index of the first face-up card of each tableau pile.
+     */
+    std::uint8_t tableauShown[kTableauSize];
+
+    /**
+     * The cards of each tableau pile, from the bottom up.
+     */
+    CardCode tableau[kTableauSize][kMaxTableauPileSize];
+
+    /**
+     * Deals the game with the given deal number, the same one Board::Reset
+     * deals.
+     */
+    void Deal(std::uint64_t dealNumber, int numOpenCards);
+
+    /**
+     * Deals the kDeckSize cards in order: the first seven piles of the
+     * tableau from left to right, and the rest to the stock.
+     */
+    void Deal(const CardCode* cards, int numOpenCards);
+
+    /**
+     * Checks whether the talon is empty.
+     */
+    bool TalonEmpty() const { return talon == deckSize; }
+
+    /**
+     * Returns the accessible card from the talon.
+     */
+    CardCode TalonCard() const { return deck[stock - 1]; }
+
+    /**
+     * Returns whether every card has been moved to the foundation.
+     */
+    bool IsWon() const;
+
+    /**
+     * Returns whether the game is won whatever is played next, as it is once
+     * every tableau card is face up and dealing can make any card left in the
+     * deck the talon card: the lowest card not on the foundation can then
+     * always be played there. Takes constant time.
+     */
+    bool CanAutoComplete() const {
+      return numFaceDown == 0 && (numOpenCards == 1 || deckSize <= 1);
+    }
+
+    /**
+     * Plays out a game CanAutoComplete says is won, appending each move to
+     * moves: the safe moves to the foundation there are, and one new talon at
+     * a time while there are none. Returns false if a whole pass through the
+     * stock turns up no safe move, as it can in a position whose face-up
+     * cards are out of run, leaving the moves played until then.
+     */
+    bool AutoComplete(std::vector<Move>& moves);
+
+    /**
+     * Fills the buffer with every legal move in the position, with moves to
+     * the foundation first and the new talon last.
+     */
+    void GenerateMoves(MoveBuffer& moves) const;
+
+    /**
+     * Fills the buffer with the same moves as GenerateMoves, but in place of
+     * dealing one new talon, one move for each card that dealing new talons
+     * can make the talon card and that can then be played: a NEW_TALON move
+     * whose count is how many new talons it deals at once, fewest first.
+     * Dealing new talons changes nothing any other move but playing the
+     * talon card looks at, so a search loses no line of play by dealing only
+     * right before it plays the card dealt to.
+     *
+     * Unless kDrawCount is kAnyDrawCount, it must be the position's
+     * numOpenCards, which then need not be read while walking the stock.
+     */
+    template <int kDrawCount = kAnyDrawCount>
+    void GenerateMacroMoves(MoveBuffer& moves) const;
+
+    /**
+     * Finds a move to the foundation that no line of play needs to put off:
+     * the card is an ace or a two, or both cards of the other color one rank
+     * lower are on the foundation already, so the card will never have to
+     * hold one in the tableau. Looks at the talon card first. Returns false
+     * if there is none.
+     */
+    bool FindSafeMove(Move& move) const;
+
+    /**
+     * Plays the move following the same rules as the Board::Do* method it
+     * names, and a NEW_TALON move of count more than 1 as that many new
+     * talons. Returns false and leaves the position as is if the move is
+     * illegal.
+     */
+    bool ApplyMove(Move move);
+
+    /**
+     * Plays the move like ApplyMove(Move) and, if it is legal, fills in the
+     * record that Undo needs to take it back. Unless kDrawCount is
+     * kAnyDrawCount, it must be the position's numOpenCards.
+     */
+    template <int kDrawCount = kAnyDrawCount>
+    bool ApplyMove(Move move, UndoRecord& record);
+
+    /**
+     * Takes back the last move played, given the record ApplyMove filled in
+     * for it. Moves must be taken back in the reverse order they were played.
+     */
+    void Undo(const UndoRecord& record);
+
+    /**
+     * Returns the Zobrist hash of the position, the same one Board::Hash
+     * returns.
+     */
+    std::uint64_t Hash() const { return hash; }
+
+    /**
+     * Computes the hash of the position from scratch.
+     */
+    std::uint64_t ComputeHash() const;
+
+    /**
+     * Returns a hash of the position that stays the same when tableau piles
+     * trade places or foundation piles do, so positions that differ only in
+     * that way count as one.
+     */
+    std::uint64_t SymmetricHash() const { return hash ^ symmetricDelta; }
+
+    /**
+     * Computes the symmetric hash of the position from scratch.
+     */
+    std::uint64_t ComputeSymmetricHash() const;
+
+    /**
+     * Returns the symmetric hash, but with the stock and talon cursors left
+     * out while they are at a place that dealing new talons from an empty
+     * talon passes through. Dealing alone takes the cursors from any such
+     * place to any other and back, so positions that differ only there are
+     * won or lost together, but reaching one from another can take many
+     * moves. Unless kDrawCount is kAnyDrawCount, it must be the position's
+     * numOpenCards.
+     */
+    template <int kDrawCount = kAnyDrawCount>
+    std::uint64_t ProofHash() const;
+
+    /**
+     * Sets both hashes of the position, computed from scratch.
+     */
+    void ResetHashes();
+  };
+
+  static_assert(std::is_trivially_copyable<PackedBoard>::value,
+                "PackedBoard must be copyable with memcpy");
+  static_assert(sizeof(PackedBoard) <= 256,
+                "PackedBoard should stay within a few cache lines");
+
+  /**
+   * Calls the function with a std::integral_constant of the draw count, 1 or
+   * 3, or of kAnyDrawCount for any other, and returns what it returns. A
+   * search calls it once, at its root, so that every position under it is
+   * played by the methods compiled for its draw count.
+   */
+  template <class Function>
+  auto WithDrawCount(int numOpenCards, Function&& function) {
+    switch (numOpenCards) {
+    case 1:
+      return function(std::integral_constant<int, 1>());
+    case 3:
+      return function(std::integral_constant<int, 3>());
+    default:
+      return function(std::integral_constant<int, kAnyDrawCount>());
+    }
+  }
+}
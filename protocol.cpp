@@ -0,0 +1,161 @@
+/**
+ * @file protocol.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A line-oriented command protocol for playing without prompts.
+ */
+#include <algorithm>
+#include <charconv>
+#include <string>
+#include "notation.h"
+#include "protocol.h"
+#include "solitaire.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * Splits the first word off the text, or returns an empty word if there is
+   * none.
+   */
+  static string_view TakeWord(string_view& text) {
+    size_t begin = min(text.find_first_not_of(" \t\r"), text.size());
+    size_t end = min(text.find_first_of(" \t\r", begin), text.size());
+    string_view word = text.substr(begin, end - begin);
+    text.remove_prefix(end);
+    return word;
+  }
+
+  /**
+   * Reads a number that is the whole word.
+   */
+  template <typename Number>
+  static bool ParseNumber(string_view word, Number& number) {
+    const char* end = word.data() + word.size();
+    from_chars_result result = from_chars(word.data(), end, number);
+    return !word.empty() && result.ec == errc() && result.ptr == end;
+  }
+
+  CommandSession::CommandSession(uint64_t dealNumber, int numOpenCards)
+    : game(dealNumber, numOpenCards),
+      dealNumber(dealNumber),
+      numOpenCards(numOpenCards) { }
+
+  void CommandSession::ReportStatus(ostream& out) const {
+    out << "ok " << StringOf(game.GetStatus()) << "\n";
+  }
+
+  bool CommandSession::Execute(string_view line, ostream& out) {
+    SOLITAIRE_TIME(COMMAND);
+    string_view rest = line;
+    string_view command = TakeWord(rest);
+    if (command.empty() || command[0] == '#') {
+      return true;
+    }
+
+    Move move;
+    if (Move::Parse(command, move)) {
+      if (!TakeWord(rest).empty()) {
+        out << "error extra arguments\n";
+      } else if (game.ApplyMove(move)) {
+        ReportStatus(out);
+      } else {
+        out << "error illegal move\n";
+      }
+    } else if (command == "undo") {
+      if (game.Undo()) {
+        ReportStatus(out);
+      } else {
+        out << "error nothing to undo\n";
+      }
+    } else if (command == "redo") {
+      if (game.Redo()) {
+        ReportStatus(out);
+      } else {
+        out << "error nothing to redo\n";
+      }
+    } else if (command == "new") {
+      uint64_t newDealNumber = dealNumber + 1;
+      int newNumOpenCards = numOpenCards;
+      string_view deal = TakeWord(rest);
+      string_view draw = TakeWord(rest);
+      if ((!deal.empty() && !ParseNumber(deal, newDealNumber))
+          || (!draw.empty() && !ParseNumber(draw, newNumOpenCards))
+          || (newNumOpenCards != kOneCardGame
+              && newNumOpenCards != kThreeCardGame)
+          || !TakeWord(rest).empty()) {
+        out << "error bad deal\n";
+      } else {
+        dealNumber = newDealNumber;
+        numOpenCards = newNumOpenCards;
+        game.Reset(numOpenCards, dealNumber);
+        out << "ok " << dealNumber << "\n";
+      }
+    } else if (command == "auto") {
+      string_view setting = TakeWord(rest);
+      if ((setting != "on" && setting != "off") || !TakeWord(rest).empty()) {
+        out << "error bad setting\n";
+      } else {
+        game.SetAutoPlay(setting == "on");
+        ReportStatus(out);
+      }
+    } else if (command == "complete") {
+      if (!TakeWord(rest).empty()) {
+        out << "error extra arguments\n";
+      } else if (game.AutoComplete()) {
+        ReportStatus(out);
+      } else {
+        out << "error not won yet\n";
+      }
+    } else if (command == "moves") {
+      MoveBuffer moves;
+      game.GenerateMoves(moves);
+      out << "ok";
+      for (int i = 0; i < moves.Size(); i++) {
+        out << " ";
+        moves[i].Print(out);
+      }
+      out << "\n";
+    } else if (command == "status") {
+      ReportStatus(out);
+    } else if (command == "show") {
+      char text[kMaxPositionTextSize];
+      char* end = FormatPosition(game.Pack(), text);
+      out << "ok ";
+      out.write(text, end - text);
+      out << "\n";
+    } else if (command == "load") {
+      PackedBoard packed;
+      if (ParsePosition(rest, packed)) {
+        game.Unpack(packed);
+        numOpenCards = packed.numOpenCards;
+        ReportStatus(out);
+      } else {
+        out << "error bad position\n";
+      }
+    } else if (command == "quit") {
+      out << "ok\n";
+      return false;
+    } else {
+      out << "error unknown command\n";
+    }
+    return true;
+  }
+
+  uint64_t RunCommands(CommandSession& session, istream& in, ostream& out,
+                       bool flushEachResult) {
+    uint64_t numCommands = 0;
+    string line;
+    bool running = true;
+    while (running && getline(in, line)) {
+      running = session.Execute(line, out);
+      numCommands++;
+      if (flushEachResult) {
+        out.flush();
+      }
+    }
+    out.flush();
+    return numCommands;
+  }
+}
@@ -0,0 +1,71 @@
+/**
+ * @file protocol.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A line-oriented command protocol for playing without prompts.
+ *
+ * Each line of input is one command, and each command writes one line of
+ * output that starts with "ok" or "error". Blank lines and lines starting
+ * with '#' are skipped without output. The commands are
+ *
+ *     draw, wf, w>4, t2f, t3>5, f1>4   plays the move; ok <status>
+ *     undo, redo                       ok <status>
+ *     auto on|off                      turns auto-play on or off; ok <status>
+ *     complete                         plays out a won game; ok <status>
+ *     new [deal [draw]]                deals a game; ok <deal>
+ *     moves                            ok <legal moves...>
+ *     status                           ok <status>
+ *     show                             ok <position>
+ *     load <position>                  ok <status>
+ *     quit                             ok, and stops reading
+ *
+ * where moves and positions are written in the notations of Move::Print and
+ * notation.h and the status is playing, stuck or won.
+ */
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string_view>
+#include "board.h"
+
+namespace solitaire {
+  /**
+   * CommandSession holds the game that commands play on.
+   */
+  class CommandSession {
+  private:
+    Board game;
+    std::uint64_t dealNumber;
+    int numOpenCards;
+
+    /**
+     * Writes ok and the status of the game.
+     */
+    void ReportStatus(std::ostream& out) const;
+
+  public:
+    /**
+     * Starts the session on the deal with the given number.
+     */
+    CommandSession(std::uint64_t dealNumber, int numOpenCards);
+
+    /**
+     * Runs the command on the line and writes its result. Returns false if
+     * the command was quit.
+     */
+    bool Execute(std::string_view line, std::ostream& out);
+
+    /**
+     * Returns the game.
+     */
+    const Board& GetGame() const { return game; }
+  };
+
+  /**
+   * Runs every command read from the input until it ends or a quit, flushing
+   * the output after each result if asked to. Returns the number of lines
+   * read.
+   */
+  std::uint64_t RunCommands(CommandSession& session, std::istream& in,
+                            std::ostream& out, bool flushEachResult);
+}
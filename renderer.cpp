@@ -0,0 +1,99 @@
+/**
+ * @file renderer.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Draws a Solitaire board to a terminal one frame at a time.
+ */
+#include "renderer.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  Renderer::Renderer(Mode mode) : mode(mode) { }
+
+  void Renderer::Invalidate() {
+    lines.clear();
+  }
+
+  /**
+   * Appends the escape sequence that moves the cursor to the row and column,
+   * counting from 1.
+   */
+  static void MoveCursor(string& out, size_t row, size_t column) {
+    out += "\033[";
+    out += to_string(row);
+    out += ';';
+    out += to_string(column);
+    out += 'H';
+  }
+
+  /**
+   * Returns true if the byte starts a character rather than continuing one in
+   * UTF-8.
+   */
+  static inline bool StartsCharacter(char c) {
+    return (static_cast<unsigned char>(c) & 0xc0) != 0x80;
+  }
+
+  void Renderer::Diff() {
+    if (lines.empty()) { // start from a clear screen
+      output += "\033[H\033[2J";
+    }
+
+    size_t row = 0;
+    size_t begin = 0;
+    for (size_t end; (end = frame.find('\n', begin)) != string::npos;
+         begin = end + 1, row++) {
+      const char* line = frame.data() + begin;
+      size_t length = end - begin;
+      // rows below the last frame may hold other text, so write them whole
+      bool drawn = row < lines.size();
+      if (!drawn) {
+        lines.emplace_back();
+      }
+      string& old = lines[row];
+
+      // find the first character that differs and the column it is in
+      size_t same = 0;
+      size_t column = 0;
+      while (drawn && same < length && same < old.size()
+             && line[same] == old[same]) {
+        same++;
+      }
+      if (drawn && same == length && same == old.size()) {
+        continue;
+      }
+      while (same > 0 && !StartsCharacter(line[same])) {
+        same--;
+      }
+      for (size_t i = 0; i < same; i++) {
+        column += StartsCharacter(line[i]);
+      }
+
+      MoveCursor(output, row + 1, column + 1);
+      output.append(line + same, length - same);
+      output += "\033[K";
+      old.assign(line, length);
+    }
+
+    // clear whatever was written below the frame, and leave the cursor there
+    lines.resize(row);
+    MoveCursor(output, row + 1, 1);
+    output += "\033[J";
+  }
+
+  void Renderer::Draw(const Board& board, ostream& out) {
+    SOLITAIRE_TIME(RENDER);
+    frame.clear();
+    board.DrawFrame(frame);
+    if (mode == Mode::PLAIN) {
+      out.write(frame.data(), frame.size());
+    } else {
+      output.clear();
+      Diff();
+      out.write(output.data(), output.size());
+    }
+    out.flush();
+  }
+}
@@ -0,0 +1,53 @@
+/**
+ * @file renderer.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Draws a Solitaire board to a terminal one frame at a time.
+ */
+#pragma once
+#include <ostream>
+#include <string>
+#include <vector>
+#include "board.h"
+
+namespace solitaire {
+  /**
+   * Renderer draws boards in the layout of Board::DrawBoard, building each
+   * frame in a buffer it keeps between frames and sending it with a single
+   * write. In ANSI mode it keeps the board at the top of the terminal and
+   * rewrites only the part of each line that changed since the last frame.
+   */
+  class Renderer {
+  public:
+    enum class Mode { PLAIN, ANSI };
+
+  private:
+    Mode mode;
+    std::string frame;
+    std::string output;
+    std::vector<std::string> lines;
+
+    /**
+     * Appends to output the escape sequences and text that turn the lines of
+     * the last frame into the lines of this one.
+     */
+    void Diff();
+
+  public:
+    /**
+     * Creates a renderer that draws in the given mode.
+     */
+    explicit Renderer(Mode mode = Mode::PLAIN);
+
+    /**
+     * Draws the board.
+     */
+    void Draw(const Board& board, std::ostream& out = std::cout);
+
+    /**
+     * Makes the next frame redraw the whole board, for when the screen was
+     * changed by something else.
+     */
+    void Invalidate();
+  };
+}
@@ -0,0 +1,127 @@
+/**
+ * @file replay.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Replays the recorded games of a corpus and reports divergences.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "corpus.h"
+#include "notation.h"
+#include "replayer.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+using namespace std;
+using namespace solitaire;
+
+static void PrintUsage(const char* program) {
+  cerr << "Usage: " << program << " [-j threads] [--stats] corpus" << endl
+       << endl
+       << "Plays every recorded game of the corpus again through the board and"
+       << endl
+       << "prints one line per game that diverges: the deal number, what went"
+       << endl
+       << "wrong, the index of the move at fault and that move, or the status"
+       << endl
+       << "the game ended in. Exits with status 2 if any game diverged. With"
+       << endl
+       << "--stats, writes what the engine counted as JSON to stderr at exit"
+       << endl
+       << "and on SIGUSR1." << endl;
+}
+
+static const char* StringOf(ReplayResult::Verdict verdict) {
+  switch (verdict) {
+  case ReplayResult::Verdict::OK:
+    return "ok";
+  case ReplayResult::Verdict::ILLEGAL_MOVE:
+    return "illegal-move";
+  case ReplayResult::Verdict::WRONG_STATUS:
+    return "wrong-status";
+  default:
+    return "engine-mismatch";
+  }
+}
+
+/**
+ * The number of games replayed between writing out divergences, which keeps
+ * the output in deal order.
+ */
+static const uint64_t kBlockSize = 1 << 16;
+
+int main(int argc, char* argv[]) {
+  int numThreads = 0;
+  bool stats = false;
+  int argi = 1;
+  for (/**/; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+      numThreads = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "--stats") == 0) {
+      stats = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (argi + 1 != argc) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  const char* inputPath = argv[argi];
+  CorpusReader input;
+  if (!input.Open(inputPath)) {
+    cerr << "Cannot read the corpus " << inputPath << endl;
+    return 1;
+  }
+
+  // each worker replays on its own boards
+  StatsReport report(stats);
+  ThreadPool pool(numThreads);
+  vector<Board> games(pool.NumThreads());
+  vector<PackedBoard> boards(pool.NumThreads());
+  uint64_t count = input.NumDeals();
+  vector<ReplayResult> results(min(count, kBlockSize));
+  uint64_t totalMoves = 0;
+  uint64_t numDiverged = 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (uint64_t blockFirst = 0; blockFirst < count; blockFirst += kBlockSize) {
+    uint64_t blockLast = min(count, blockFirst + kBlockSize);
+    pool.ParallelFor(blockFirst, blockLast, [&](int worker, uint64_t i) {
+        results[i - blockFirst] = Replay(input.GetDeal(i),
+                                         input.SolutionBegin(i),
+                                         input.SolutionEnd(i),
+                                         games[worker], boards[worker]);
+      });
+
+    for (uint64_t i = blockFirst; i < blockLast; i++) {
+      const ReplayResult& result = results[i - blockFirst];
+      totalMoves += result.numMoves;
+      if (result.verdict == ReplayResult::Verdict::OK) {
+        continue;
+      }
+      numDiverged++;
+      cout << input.GetDeal(i).dealNumber << " " << StringOf(result.verdict)
+           << " " << result.numMoves << " ";
+      if (result.verdict == ReplayResult::Verdict::WRONG_STATUS) {
+        cout << StringOf(result.status);
+      } else {
+        input.SolutionBegin(i)[result.numMoves].Print(cout);
+      }
+      cout << "\n";
+    }
+  }
+  cout.flush();
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()
+                                            - start).count();
+  cerr << count << " games, " << totalMoves << " moves, " << numDiverged
+       << " diverged on " << pool.NumThreads() << " threads in " << seconds
+       << " s: " << static_cast<uint64_t>(count / seconds) << " games/s, "
+       << static_cast<uint64_t>(totalMoves / seconds) << " moves/s" << endl;
+  return numDiverged == 0 ? 0 : 2;
+}
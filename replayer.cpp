@@ -0,0 +1,51 @@
+/**
+ * @file replayer.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Replays recorded games to check them against the rules.
+ */
+#include "replayer.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  bool StatusMatches(DealLabel label, Board::Status status) {
+    switch (label) {
+    case DealLabel::SOLVED:
+      return status == Board::Status::WON;
+    case DealLabel::UNSOLVABLE:
+    case DealLabel::GAVE_UP:
+      return status != Board::Status::WON;
+    default:
+      return true;
+    }
+  }
+
+  ReplayResult Replay(const DealRecord& record, const Move* first,
+                      const Move* last, Board& game, PackedBoard& board) {
+    SOLITAIRE_TIME(REPLAY);
+    record.Deal(board);
+    game.Unpack(board);
+
+    ReplayResult result = { ReplayResult::Verdict::OK, 0,
+                            Board::Status::PLAYING };
+    for (const Move* move = first; move != last; ++move) {
+      if (!game.ApplyMove(*move)) {
+        result.verdict = ReplayResult::Verdict::ILLEGAL_MOVE;
+        break;
+      }
+      if (!board.ApplyMove(*move) || board.Hash() != game.Hash()) {
+        result.verdict = ReplayResult::Verdict::ENGINE_MISMATCH;
+        break;
+      }
+      result.numMoves++;
+    }
+    result.status = game.GetStatus();
+    if (result.verdict == ReplayResult::Verdict::OK
+        && !StatusMatches(record.label, result.status)) {
+      result.verdict = ReplayResult::Verdict::WRONG_STATUS;
+    }
+    return result;
+  }
+}
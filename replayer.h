@@ -0,0 +1,72 @@
+/**
+ * @file replayer.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Replays recorded games to check them against the rules.
+ */
+#pragma once
+#include <cstdint>
+#include "board.h"
+#include "corpus.h"
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * How a recorded game went when it was played again.
+   */
+  struct ReplayResult {
+    enum class Verdict : std::uint8_t {
+      /**
+       * Every move was legal and the game ended as its label says.
+       */
+      OK,
+
+      /**
+       * Board rejected one of the moves.
+       */
+      ILLEGAL_MOVE,
+
+      /**
+       * Every move was legal, but the game ended won when its label says it
+       * was not, or the other way around.
+       */
+      WRONG_STATUS,
+
+      /**
+       * PackedBoard did not play a move the same way Board did.
+       */
+      ENGINE_MISMATCH
+    };
+
+    Verdict verdict;
+
+    /**
+     * The number of moves played, which is also the index of the move at
+     * fault if there is one.
+     */
+    std::uint64_t numMoves;
+
+    /**
+     * The status of the game after the last move played.
+     */
+    Board::Status status;
+  };
+
+  /**
+   * Returns whether a game with the label may end with the status: a solved
+   * deal must end won, an unsolvable or given up one must not, and an
+   * unlabeled one may end either way.
+   */
+  bool StatusMatches(DealLabel label, Board::Status status);
+
+  /**
+   * Deals the record's game and plays the moves from first up to last through
+   * Board::ApplyMove, and so through the Board::Do* methods, stopping at the
+   * first illegal move. Each move is also played on the packed board, and the
+   * two engines must agree on whether it is legal and on the hash after it.
+   * The game and packed board are scratch space that a caller can reuse
+   * across games.
+   */
+  ReplayResult Replay(const DealRecord& record, const Move* first,
+                      const Move* last, Board& game, PackedBoard& board);
+}
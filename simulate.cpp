@@ -0,0 +1,110 @@
+/**
+ * @file simulate.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Plays Solitaire games end to end without a player.
+ */
+#include "simulate.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  RandomPolicy::RandomPolicy() : random(0) { }
+
+  void RandomPolicy::NewGame(const PackedBoard&, uint64_t dealNumber) {
+    // a stream apart from the one that shuffled the deal
+    random = SplitMix64(~dealNumber);
+  }
+
+  bool RandomPolicy::ChooseMove(const PackedBoard&, const MoveBuffer& moves,
+                                Move& move) {
+    move = moves[random.Below(moves.Size())];
+    return true;
+  }
+
+  void GreedyPolicy::NewGame(const PackedBoard&, uint64_t) { }
+
+  bool GreedyPolicy::ChooseMove(const PackedBoard& board,
+                                const MoveBuffer& moves, Move& move) {
+    const int kSplitsRun = 4;
+    const int kFromFoundation = 6;
+    int best = kNumPriorities;
+    for (int i = 0; i < moves.Size(); i++) {
+      int priority = PriorityOf(board, moves[i]);
+      if (priority < 0 || priority == kSplitsRun
+          || priority == kFromFoundation) {
+        continue;
+      }
+      if (priority < best) {
+        best = priority;
+        move = moves[i];
+      }
+    }
+    return best < kNumPriorities;
+  }
+
+  SolverPolicy::SolverPolicy(uint64_t maxNodes)
+    : solver(maxNodes), solved(false), next(0) { }
+
+  void SolverPolicy::NewGame(const PackedBoard& deal, uint64_t) {
+    solved = solver.Solve(deal) == Solver::Result::SOLVED;
+    next = 0;
+  }
+
+  bool SolverPolicy::ChooseMove(const PackedBoard&, const MoveBuffer&,
+                                Move& move) {
+    if (!solved || next == solver.GetSolution().size()) {
+      return false;
+    }
+    move = solver.GetSolution()[next++];
+    return true;
+  }
+
+  unique_ptr<Policy> MakePolicy(const string& name, uint64_t maxNodes) {
+    if (name == "random") {
+      return unique_ptr<Policy>(new RandomPolicy());
+    } else if (name == "greedy") {
+      return unique_ptr<Policy>(new GreedyPolicy());
+    } else if (name == "solver") {
+      return unique_ptr<Policy>(new SolverPolicy(maxNodes));
+    }
+    return nullptr;
+  }
+
+  GameResult PlayGame(Policy& policy, uint64_t dealNumber, PackedBoard& board,
+                      vector<Move>* played) {
+    SOLITAIRE_TIME(PLAY_GAME);
+    policy.NewGame(board, dealNumber);
+
+    GameResult result = { false, 0 };
+    MoveBuffer moves;
+    int numNewTalons = 0; // in a row
+    while (result.numMoves < kMaxGameMoves) {
+      // a game that can no longer be lost needs no more moves
+      if (board.CanAutoComplete()) {
+        result.won = true;
+        break;
+      }
+      board.GenerateMoves(moves);
+      Move move;
+      if (moves.Empty() || !policy.ChooseMove(board, moves, move)
+          || !board.ApplyMove(move)) {
+        break;
+      }
+      result.numMoves++;
+      if (played != nullptr) {
+        played->push_back(move);
+      }
+
+      // a pass through the stock and back that only deals new talons leaves
+      // the game where it was
+      if (move.type != Move::Type::NEW_TALON) {
+        numNewTalons = 0;
+      } else if (++numNewTalons > board.deckSize / board.numOpenCards + 2) {
+        break;
+      }
+    }
+    return result;
+  }
+}
@@ -0,0 +1,111 @@
+/**
+ * @file simulate.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Plays Solitaire games end to end without a player.
+ */
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "deal.h"
+#include "packed_board.h"
+#include "solver.h"
+
+namespace solitaire {
+  /**
+   * Policy chooses the moves of a simulated player.
+   */
+  class Policy {
+  public:
+    virtual ~Policy() { }
+
+    /**
+     * Starts a game from the deal with the given number.
+     */
+    virtual void NewGame(const PackedBoard& deal, std::uint64_t dealNumber) = 0;
+
+    /**
+     * Sets move to the next move to play, chosen from the legal moves of the
+     * position, which are never empty. Returns false to give up the game.
+     */
+    virtual bool ChooseMove(const PackedBoard& board, const MoveBuffer& moves,
+                            Move& move) = 0;
+  };
+
+  /**
+   * RandomPolicy plays any legal move, each as likely as the others. The
+   * moves of a game depend only on its deal number.
+   */
+  class RandomPolicy : public Policy {
+  private:
+    SplitMix64 random;
+
+  public:
+    RandomPolicy();
+    void NewGame(const PackedBoard& deal, std::uint64_t dealNumber) override;
+    bool ChooseMove(const PackedBoard& board, const MoveBuffer& moves,
+                    Move& move) override;
+  };
+
+  /**
+   * GreedyPolicy plays moves to the foundation first, then the move the
+   * solver ranks most promising, but never a move that undoes progress:
+   * splitting a run or taking a card back off the foundation.
+   */
+  class GreedyPolicy : public Policy {
+  public:
+    void NewGame(const PackedBoard& deal, std::uint64_t dealNumber) override;
+    bool ChooseMove(const PackedBoard& board, const MoveBuffer& moves,
+                    Move& move) override;
+  };
+
+  /**
+   * SolverPolicy solves each deal before playing it and then plays the
+   * solution, or gives up if the solver found none.
+   */
+  class SolverPolicy : public Policy {
+  private:
+    Solver solver;
+    bool solved;
+    std::size_t next;
+
+  public:
+    explicit SolverPolicy(std::uint64_t maxNodes = Solver::kDefaultMaxNodes);
+    void NewGame(const PackedBoard& deal, std::uint64_t dealNumber) override;
+    bool ChooseMove(const PackedBoard& board, const MoveBuffer& moves,
+                    Move& move) override;
+  };
+
+  /**
+   * Returns a new policy of the named kind, "random", "greedy" or "solver",
+   * or nullptr if there is no such kind. The solver policy gives up after
+   * maxNodes positions.
+   */
+  std::unique_ptr<Policy> MakePolicy(const std::string& name,
+                                     std::uint64_t maxNodes);
+
+  /**
+   * How a simulated game ended.
+   */
+  struct GameResult {
+    bool won;
+    int numMoves;
+  };
+
+  /**
+   * The most moves a simulated game may take before it counts as lost.
+   */
+  const int kMaxGameMoves = 2000;
+
+  /**
+   * Plays the game dealt on the board to the end with the policy, leaving the
+   * last position on the board, and appends the moves played to moves if it
+   * is not null. A game is lost when the policy gives up, when only dealing
+   * new talons is left and a whole pass through the stock changes nothing,
+   * or after kMaxGameMoves moves.
+   */
+  GameResult PlayGame(Policy& policy, std::uint64_t dealNumber,
+                      PackedBoard& board, std::vector<Move>* moves = nullptr);
+}
@@ -5,8 +5,22 @@
  * @brief Implements solitaire (Klondike).
  */
 #include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <limits>
+#include <memory>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "corpus.h"
+#include "protocol.h"
+#include "renderer.h"
+#include "simulate.h"
 #include "solitaire.h"
+#include "stats.h"
+#include "thread_pool.h"
 
 using namespace std;
 
@@ -91,33 +105,35 @@ namespace solitaire {
          << "(1) Deal new upturned card(s)" << endl
          << "(2) Move card(s)" << endl
          << "(3) Get a hint" << endl
-         << "(4) Restart the game" << endl
+         << "(4) Undo the last move" << endl
+         << "(5) Redo the last move undone" << endl
+         << "(6) Restart the game" << endl
          << endl
          << "Select an option: ";
     return GetOptionRange(Play::TALON, Play::RESTART);
   }
 
-  bool DoMove(Board& game, Move moveOption) {
+  bool DoMove(Board& game, MoveOption moveOption) {
     switch(moveOption) {
-    case Move::TALON_TO_FOUNDATION:
+    case MoveOption::TALON_TO_FOUNDATION:
       return game.DoMoveTalonToFoundation();
 
-    case Move::TABLEAU_TO_FOUNDATION:
+    case MoveOption::TABLEAU_TO_FOUNDATION:
       cout << "Which tableau pile contains the card to move to the foundation? ";
       return game.DoMoveTableauToFoundation(GetOptionRange(0, kTableauSize - 1));
 
-    case Move::TALON_TO_TABLEAU:
+    case MoveOption::TALON_TO_TABLEAU:
       cout << "To which tableau pile will the talon card move? ";
       return game.DoMoveTalonToTableau(GetOptionRange(0, kTableauSize - 1));
 
-    case Move::TABLEAU_TO_TABLEAU: {
+    case MoveOption::TABLEAU_TO_TABLEAU: {
       cout << "From which tableau pile will the card(s) move? ";
       int fromIdx = GetOptionRange(0, kTableauSize - 1);
       cout << "To which tableau pile will the card(s) move? ";
       int toIdx = GetOptionRange(0, kTableauSize - 1);
       return game.DoMoveTableauToTableau(fromIdx, toIdx);
     }
-    case Move::FOUNDATION_TO_TABLEAU: {
+    case MoveOption::FOUNDATION_TO_TABLEAU: {
       cout << "From which foundation pile will the card move? ";
       int foundationIdx = GetOptionRange(0, kNumSuits - 1);
       cout << "To which tableau pile will the card move? ";
@@ -129,7 +145,43 @@ namespace solitaire {
     }
   }
 
-  bool DoPlay(Board& game, Play playOption) {
+  void PrintHint(const Board& game, const HintSearch& hints) {
+    Move move;
+    int depth;
+    if (!hints.GetBest(move, depth)) {
+      game.DoGetHint();
+      return;
+    }
+    cout << endl
+         << "Hint: ";
+    switch (move.type) {
+    case Move::Type::NEW_TALON:
+      cout << "deal new upturned card(s)";
+      break;
+    case Move::Type::TALON_TO_FOUNDATION:
+      cout << "move the talon card to the foundation";
+      break;
+    case Move::Type::TABLEAU_TO_FOUNDATION:
+      cout << "move the card from tableau pile " << int(move.from)
+           << " to the foundation";
+      break;
+    case Move::Type::TALON_TO_TABLEAU:
+      cout << "move the talon card to tableau pile " << int(move.to);
+      break;
+    case Move::Type::FOUNDATION_TO_TABLEAU:
+      cout << "move the card from foundation pile " << int(move.from)
+           << " to tableau pile " << int(move.to);
+      break;
+    case Move::Type::TABLEAU_TO_TABLEAU:
+      cout << "move card(s) from tableau pile " << int(move.from)
+           << " to tableau pile " << int(move.to);
+      break;
+    }
+    cout << " (looked " << depth << " move(s) ahead)." << endl
+         << endl;
+  }
+
+  bool DoPlay(Board& game, Play playOption, const HintSearch& hints) {
     switch (playOption) {
     case Play::TALON:
       return game.DoNewTalon();
@@ -144,13 +196,20 @@ namespace solitaire {
            << "(5) Foundation to the tableau" << endl
            << endl
            << "Select a move: ";
-      return DoMove(game, GetOptionRange(Move::TALON_TO_FOUNDATION,
-                                         Move::FOUNDATION_TO_TABLEAU));
+      return DoMove(game,
+                    GetOptionRange(MoveOption::TALON_TO_FOUNDATION,
+                                   MoveOption::FOUNDATION_TO_TABLEAU));
 
     case Play::HINT:
-      game.DoGetHint();
+      PrintHint(game, hints);
       return true;
 
+    case Play::UNDO:
+      return game.Undo();
+
+    case Play::REDO:
+      return game.Redo();
+
     case Play::RESTART:
       cout << "Are you sure you want to reset the board and restart your game (y/n)? ";
       if (GetBoolChoice("y", "n")) {
@@ -166,31 +225,319 @@ namespace solitaire {
 
 using namespace solitaire;
 
-int main() {
+static void PrintUsage(const char* program) {
+  cerr << "Usage: " << program << " [--ansi] [--auto-play] [--auto-complete]"
+       << endl
+       << "       [--hint-seconds seconds] [--hint-mb megabytes] [--stats]"
+       << endl
+       << "       " << program << " --commands [file] [-d 1|3] [--deal deal]"
+       << endl
+       << "       " << program << " --simulate count [--policy random|greedy"
+       << "|solver] [-d 1|3] [--first deal] [-j threads] [-n max-nodes]"
+       << " [--input corpus] [--output corpus]" << endl
+       << endl
+       << "Plays Solitaire; with --ansi, redraws only what changed on the"
+       << endl
+       << "terminal. Hints come from a search that runs while you think, for"
+       << endl
+       << "at most the given seconds and megabytes per position (by default"
+       << endl
+       << HintSearch::kDefaultSeconds << " and " << HintSearch::kDefaultMegabytes
+       << "). With --auto-play, cards go to the foundation by themselves" << endl
+       << "whenever no line of play could need them in the tableau. The game"
+       << endl
+       << "is won once it can no longer be lost; with --auto-complete, its"
+       << endl
+       << "last moves are then played for you." << endl
+       << endl
+       << "With --commands, reads one command per line from the file or stdin"
+       << endl
+       << "and writes one result per line, without prompts." << endl
+       << endl
+       << "With --simulate, plays the count deals numbered from first on, or"
+       << endl
+       << "the count deals of the input corpus from index first on, with the"
+       << endl
+       << "policy and reports the win rate, the moves per game and the games"
+       << endl
+       << "per second. With --output, also writes the deals, results and moves"
+       << endl
+       << "to a corpus file." << endl
+       << endl
+       << "With --stats, in any mode, writes what the engine counted as JSON"
+       << endl
+       << "to stderr at exit and on SIGUSR1." << endl;
+}
+
+/**
+ * Plays the commands of a file or stdin and writes their results to stdout.
+ */
+static int PlayCommands(int argc, char* argv[]) {
+  const char* path = nullptr;
+  int numOpenCards = kThreeCardGame;
+  uint64_t dealNumber = 0;
+  for (int argi = 2; argi < argc; argi++) {
+    if (strcmp(argv[argi], "-d") == 0 && argi + 1 < argc) {
+      numOpenCards = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "--deal") == 0 && argi + 1 < argc) {
+      dealNumber = strtoull(argv[++argi], nullptr, 10);
+    } else if (path == nullptr && argv[argi][0] != '-') {
+      path = argv[argi];
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (numOpenCards != kOneCardGame && numOpenCards != kThreeCardGame) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  // read and write through large buffers, and answer a pipe line by line
+  ios::sync_with_stdio(false);
+  cin.tie(nullptr);
+  CommandSession session(dealNumber, numOpenCards);
+  if (path != nullptr) {
+    ifstream file(path);
+    if (!file) {
+      cerr << "Cannot read the commands " << path << endl;
+      return 1;
+    }
+    RunCommands(session, file, cout, false);
+  } else {
+    struct stat info;
+    bool fromFile = fstat(STDIN_FILENO, &info) == 0 && S_ISREG(info.st_mode);
+    RunCommands(session, cin, cout, !fromFile);
+  }
+  return 0;
+}
+
+/**
+ * The number of games played between writing out results, which keeps the
+ * output corpus in deal order without holding every game in memory.
+ */
+static const uint64_t kBlockSize = 1 << 16;
+
+/**
+ * Plays games with a policy instead of a player and reports how it did.
+ */
+static int Simulate(int argc, char* argv[]) {
+  uint64_t count = 0;
+  string policyName = "greedy";
+  int numOpenCards = kThreeCardGame;
+  uint64_t first = 0;
+  int numThreads = 0;
+  uint64_t maxNodes = Solver::kDefaultMaxNodes;
+  const char* inputPath = nullptr;
+  const char* outputPath = nullptr;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "--simulate") == 0 && argi + 1 < argc) {
+      count = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "--policy") == 0 && argi + 1 < argc) {
+      policyName = argv[++argi];
+    } else if (strcmp(argv[argi], "-d") == 0 && argi + 1 < argc) {
+      numOpenCards = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "--first") == 0 && argi + 1 < argc) {
+      first = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+      numThreads = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) {
+      maxNodes = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "--input") == 0 && argi + 1 < argc) {
+      inputPath = argv[++argi];
+    } else if (strcmp(argv[argi], "--output") == 0 && argi + 1 < argc) {
+      outputPath = argv[++argi];
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (count == 0 || !MakePolicy(policyName, maxNodes)
+      || (numOpenCards != kOneCardGame && numOpenCards != kThreeCardGame)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  CorpusReader input;
+  if (inputPath != nullptr) {
+    if (!input.Open(inputPath)) {
+      cerr << "Cannot read the corpus " << inputPath << endl;
+      return 1;
+    }
+    first = min(first, input.NumDeals());
+    count = min(count, input.NumDeals() - first);
+  }
+  CorpusWriter output;
+  if (outputPath != nullptr && !output.Open(outputPath)) {
+    cerr << "Cannot write the corpus " << outputPath << endl;
+    return 1;
+  }
+
+  // each worker plays with its own policy and board
+  ThreadPool pool(numThreads);
+  vector<unique_ptr<Policy>> policies;
+  for (int i = 0; i < pool.NumThreads(); i++) {
+    policies.push_back(MakePolicy(policyName, maxNodes));
+  }
+  vector<PackedBoard> boards(pool.NumThreads());
+  vector<GameResult> results(min(count, kBlockSize));
+  vector<vector<Move>> moves(outputPath != nullptr ? results.size() : 0);
+  uint64_t totalWon = 0;
+  uint64_t totalMoves = 0;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (uint64_t blockFirst = 0; blockFirst < count; blockFirst += kBlockSize) {
+    uint64_t blockLast = min(count, blockFirst + kBlockSize);
+    pool.ParallelFor(blockFirst, blockLast, [&](int worker, uint64_t i) {
+        PackedBoard& board = boards[worker];
+        uint64_t dealNumber = first + i;
+        if (inputPath != nullptr) {
+          const DealRecord& record = input.GetDeal(first + i);
+          record.Deal(board);
+          dealNumber = record.dealNumber;
+        } else {
+          board.Deal(dealNumber, numOpenCards);
+        }
+        vector<Move>* played = nullptr;
+        if (outputPath != nullptr) {
+          played = &moves[i - blockFirst];
+          played->clear();
+        }
+        results[i - blockFirst] = PlayGame(*policies[worker], dealNumber,
+                                           board, played);
+      });
+
+    for (uint64_t i = blockFirst; i < blockLast; i++) {
+      const GameResult& result = results[i - blockFirst];
+      totalWon += result.won;
+      totalMoves += result.numMoves;
+      if (outputPath != nullptr) {
+        DealRecord record = inputPath != nullptr ? input.GetDeal(first + i)
+          : RecordOf(first + i, numOpenCards);
+        record.label = result.won ? DealLabel::SOLVED : DealLabel::GAVE_UP;
+        const vector<Move>& played = moves[i - blockFirst];
+        output.Add(record, played.data(), played.data() + played.size());
+      }
+    }
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()
+                                            - start).count();
+  if (outputPath != nullptr && !output.Close()) {
+    cerr << "Cannot write the corpus " << outputPath << endl;
+    return 1;
+  }
+
+  cout << count << " games, " << policyName << " policy, ";
+  if (inputPath != nullptr) {
+    cout << "from " << inputPath;
+  } else {
+    cout << "draw " << numOpenCards;
+  }
+  cout << ", on " << pool.NumThreads() << " threads in " << seconds << " s"
+       << endl
+       << "win rate: " << 100.0 * totalWon / max(count, uint64_t(1)) << "% ("
+       << totalWon << " won)" << endl
+       << "moves per game: "
+       << double(totalMoves) / max(count, uint64_t(1)) << endl
+       << "games per second: " << static_cast<uint64_t>(count / seconds)
+       << endl;
+  return 0;
+}
+
+/**
+ * Shows the stuck game and offers to restart it, dealing new games for as
+ * long as the player wants to and each one is stuck from the start.
+ */
+static void OfferRestart(Board& game, Renderer& renderer) {
+  while (game.GetStatus() == Board::Status::STUCK) {
+    cout << "\n";
+    renderer.Draw(game);
+    cout << endl
+         << "You have no more valid moves! Would you like to restart (y/n)? " << endl;
+    if (!GetBoolChoice("y", "n")) {
+      return;
+    }
+    cout << "Resetting..." << endl;
+    game.Reset(GetGameConfig());
+  }
+}
+
+int main(int argc, char* argv[]) {
+  // --stats works in every mode, so take it out before the modes parse
+  bool stats = false;
+  int numArgs = 1;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "--stats") == 0) {
+      stats = true;
+    } else {
+      argv[numArgs++] = argv[argi];
+    }
+  }
+  argc = numArgs;
+  StatsReport report(stats);
+
+  if (argc > 1 && strcmp(argv[1], "--commands") == 0) {
+    return PlayCommands(argc, argv);
+  }
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "--simulate") == 0) {
+      return Simulate(argc, argv);
+    }
+  }
+  bool ansi = false;
+  bool autoPlay = false;
+  bool autoComplete = false;
+  double hintSeconds = HintSearch::kDefaultSeconds;
+  size_t hintMegabytes = HintSearch::kDefaultMegabytes;
+  for (int argi = 1; argi < argc; argi++) {
+    if (strcmp(argv[argi], "--ansi") == 0) {
+      ansi = true;
+    } else if (strcmp(argv[argi], "--auto-play") == 0) {
+      autoPlay = true;
+    } else if (strcmp(argv[argi], "--auto-complete") == 0) {
+      autoComplete = true;
+    } else if (strcmp(argv[argi], "--hint-seconds") == 0 && argi + 1 < argc) {
+      hintSeconds = atof(argv[++argi]);
+    } else if (strcmp(argv[argi], "--hint-mb") == 0 && argi + 1 < argc) {
+      hintMegabytes = strtoull(argv[++argi], nullptr, 10);
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  Renderer renderer(ansi ? Renderer::Mode::ANSI : Renderer::Mode::PLAIN);
+  HintSearch hints(hintSeconds, hintMegabytes);
+
   int numOpenCards;
 
   // start the game and display board
   numOpenCards = GetGameConfig();
   Board game(numOpenCards);
+  game.SetAutoPlay(autoPlay);
+  // exact stuck detection finds some deals stuck before the first move
+  OfferRestart(game, renderer);
 
   // while the game still has valid moves or the user wants to continue playing
   while (game) {
-    cout << endl;
-    game.DrawBoard();
-    if (!DoPlay(game, GetPlay())) {
+    cout << "\n";
+    renderer.Draw(game);
+
+    // think about a hint while the player does
+    hints.Start(game.Pack());
+    if (!DoPlay(game, GetPlay(), hints)) {
       cout << endl
            << "Nothing done." << endl;
     }
     Board::Status status = game.GetStatus();
     if (status == Board::Status::WON) {
+      if (autoComplete && game.AutoComplete()) {
+        cout << "\n";
+        renderer.Draw(game);
+      }
       cout << endl
            << "You won!" << endl;
     } else if (status == Board::Status::STUCK) {
-      cout << "You have no more valid moves! Would you like to restart (y/n)? " << endl;
-      if (GetBoolChoice("y", "n")) {
-        cout << "Resetting..." << endl;
-        game.Reset(GetGameConfig());
-      }
+      OfferRestart(game, renderer);
     }
   }
 
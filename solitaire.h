@@ -6,6 +6,7 @@
  */
 #pragma once
 #include "board.h"
+#include "hint.h"
 
 /**
  * Returns the next word from @ref cin.
@@ -59,9 +60,9 @@ namespace solitaire {
    */
   int GetGameConfig();
 
-  enum class Play { TALON = 1, MOVE, HINT, RESTART };
+  enum class Play { TALON = 1, MOVE, HINT, UNDO, REDO, RESTART };
 
-  enum class Move { TALON_TO_FOUNDATION = 1, TABLEAU_TO_FOUNDATION,
+  enum class MoveOption { TALON_TO_FOUNDATION = 1, TABLEAU_TO_FOUNDATION,
       TALON_TO_TABLEAU, TABLEAU_TO_TABLEAU, FOUNDATION_TO_TABLEAU };
 
   /**
@@ -71,12 +72,18 @@ namespace solitaire {
   Play GetPlay();
 
   /**
-   * Does the selected play option.
+   * Prints the best move the hint search has found so far, or whether there
+   * is a move at all if it has not found one yet.
    */
-  bool DoPlay(Board& game, Play playOption);
+  void PrintHint(const Board& game, const HintSearch& hints);
+
+  /**
+   * Does the selected play option, answering hints from the hint search.
+   */
+  bool DoPlay(Board& game, Play playOption, const HintSearch& hints);
 
   /**
    * Does the selected move option.
    */
-  bool DoMove(Board& game, Move moveOption);
+  bool DoMove(Board& game, MoveOption moveOption);
 }
@@ -0,0 +1,245 @@
+/**
+ * @file solve.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Solves Solitaire (Klondike) deals without a player.
+ */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "corpus.h"
+#include "solitaire.h"
+#include "solver.h"
+#include "stats.h"
+#include "thread_pool.h"
+
+using namespace std;
+using namespace solitaire;
+
+static void PrintUsage(const char* program) {
+  cerr << "Usage: " << program << " [-d 1|3] [-n max-nodes] [-j threads]"
+       << " [-o corpus]" << endl
+       << "       [--tt-mb megabytes] [--shared] [--thoughtful] [--stats]"
+       << endl
+       << "       (-r first count | -i corpus | deal...)" << endl
+       << endl
+       << "Solves each numbered deal, the count deals numbered from first on,"
+       << endl
+       << "or the deals of a corpus file, and prints one line per deal: the"
+       << endl
+       << "deal number, the result, the nodes searched and the moves. With -o,"
+       << endl
+       << "also writes the deals, results and moves to a corpus file." << endl
+       << endl
+       << "Each thread remembers the positions it searched in a table of the"
+       << endl
+       << "given megabytes (" << TranspositionTable::kDefaultMegabytes
+       << " by default). With --shared, all the threads search" << endl
+       << "each deal together and share one table, which helps with a few"
+       << endl
+       << "hard deals. With --thoughtful, searches each deal for as long as it"
+       << endl
+       << "takes, ignoring -n, so that every deal is either solved or proved"
+       << endl
+       << "unsolvable by searching every position it can reach; how long that"
+       << endl
+       << "takes depends on --tt-mb, as a table too small to hold the"
+       << endl
+       << "positions of a deal makes the search visit them again. With --stats,"
+       << endl
+       << "writes what the engine counted as JSON to stderr at exit and on"
+       << endl
+       << "SIGUSR1." << endl;
+}
+
+static const char* StringOf(Solver::Result result) {
+  switch (result) {
+  case Solver::Result::SOLVED:
+    return "solved";
+  case Solver::Result::UNSOLVABLE:
+    return "unsolvable";
+  default:
+    return "gave-up";
+  }
+}
+
+/**
+ * What a worker found for one deal.
+ */
+struct DealResult {
+  Solver::Result result;
+  uint64_t nodes;
+  vector<Move> solution;
+};
+
+/**
+ * The number of deals solved between writing out results, which keeps the
+ * output in deal order without holding every result in memory.
+ */
+static const uint64_t kBlockSize = 1 << 16;
+
+int main(int argc, char* argv[]) {
+  int numOpenCards = kThreeCardGame;
+  uint64_t maxNodes = Solver::kDefaultMaxNodes;
+  int numThreads = 0;
+  bool useRange = false;
+  uint64_t first = 0;
+  uint64_t count = 0;
+  const char* inputPath = nullptr;
+  const char* outputPath = nullptr;
+  size_t tableMegabytes = TranspositionTable::kDefaultMegabytes;
+  bool shared = false;
+  bool thoughtful = false;
+  bool stats = false;
+  int argi = 1;
+  for (/**/; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (strcmp(argv[argi], "-d") == 0 && argi + 1 < argc) {
+      numOpenCards = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) {
+      maxNodes = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+      numThreads = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "-r") == 0 && argi + 2 < argc) {
+      useRange = true;
+      first = strtoull(argv[++argi], nullptr, 10);
+      count = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "-i") == 0 && argi + 1 < argc) {
+      inputPath = argv[++argi];
+    } else if (strcmp(argv[argi], "-o") == 0 && argi + 1 < argc) {
+      outputPath = argv[++argi];
+    } else if (strcmp(argv[argi], "--tt-mb") == 0 && argi + 1 < argc) {
+      tableMegabytes = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "--shared") == 0) {
+      shared = true;
+    } else if (strcmp(argv[argi], "--thoughtful") == 0) {
+      thoughtful = true;
+    } else if (strcmp(argv[argi], "--stats") == 0) {
+      stats = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if ((argi < argc) + useRange + (inputPath != nullptr) != 1
+      || (numOpenCards != kOneCardGame && numOpenCards != kThreeCardGame)) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  if (thoughtful) {
+    maxNodes = Solver::kNoMaxNodes;
+  }
+
+  vector<uint64_t> deals;
+  for (/**/; argi < argc; argi++) {
+    deals.push_back(strtoull(argv[argi], nullptr, 10));
+  }
+  CorpusReader input;
+  if (inputPath != nullptr) {
+    if (!input.Open(inputPath)) {
+      cerr << "Cannot read the corpus " << inputPath << endl;
+      return 1;
+    }
+    count = input.NumDeals();
+  } else if (!useRange) {
+    count = deals.size();
+  }
+  CorpusWriter output;
+  if (outputPath != nullptr && !output.Open(outputPath)) {
+    cerr << "Cannot write the corpus " << outputPath << endl;
+    return 1;
+  }
+
+  // the deal numbers come from one of the three sources
+  auto dealNumberOf = [&](uint64_t i) {
+    if (inputPath != nullptr) {
+      return input.GetDeal(i).dealNumber;
+    }
+    return useRange ? first + i : deals[i];
+  };
+
+  // each worker keeps its own position and search state for all its deals;
+  // shared, the workers search one deal at a time and only one table is made
+  StatsReport report(stats);
+  ThreadPool pool(numThreads);
+  vector<Solver> solvers;
+  for (int i = 0; i < pool.NumThreads(); i++) {
+    solvers.emplace_back(maxNodes, tableMegabytes);
+  }
+  unique_ptr<TranspositionTable> sharedTable;
+  if (shared) {
+    sharedTable.reset(new TranspositionTable(tableMegabytes));
+  }
+  vector<PackedBoard> boards(pool.NumThreads());
+  vector<DealResult> results(min(count, kBlockSize));
+  uint64_t totalNodes = 0;
+  uint64_t numResults[3] = { };
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  for (uint64_t blockFirst = 0; blockFirst < count; blockFirst += kBlockSize) {
+    uint64_t blockLast = min(count, blockFirst + kBlockSize);
+    auto dealOf = [&](uint64_t i, PackedBoard& board) {
+      if (inputPath != nullptr) {
+        input.GetDeal(i).Deal(board);
+      } else {
+        board.Deal(dealNumberOf(i), numOpenCards);
+      }
+    };
+    if (shared) {
+      for (uint64_t i = blockFirst; i < blockLast; i++) {
+        dealOf(i, boards[0]);
+        DealResult& result = results[i - blockFirst];
+        result.result = Solver::SolveTogether(boards[0], solvers, pool,
+                                              *sharedTable, result.solution,
+                                              result.nodes);
+      }
+    } else {
+      pool.ParallelFor(blockFirst, blockLast, [&](int worker, uint64_t i) {
+          dealOf(i, boards[worker]);
+          Solver& solver = solvers[worker];
+          DealResult& result = results[i - blockFirst];
+          result.result = solver.Solve(boards[worker]);
+          result.nodes = solver.GetNodes();
+          result.solution = solver.GetSolution();
+        });
+    }
+
+    for (uint64_t i = blockFirst; i < blockLast; i++) {
+      const DealResult& result = results[i - blockFirst];
+      totalNodes += result.nodes;
+      numResults[static_cast<int>(result.result)]++;
+      cout << dealNumberOf(i) << " "
+           << StringOf(result.result) << " " << result.nodes;
+      for (Move move : result.solution) {
+        cout << " ";
+        move.Print(cout);
+      }
+      cout << "\n";
+
+      if (outputPath != nullptr) {
+        DealRecord record = inputPath != nullptr ? input.GetDeal(i)
+          : RecordOf(dealNumberOf(i), numOpenCards);
+        record.label = static_cast<DealLabel>(result.result);
+        output.Add(record, result.solution.data(),
+                   result.solution.data() + result.solution.size());
+      }
+    }
+  }
+  cout.flush();
+  if (outputPath != nullptr && !output.Close()) {
+    cerr << "Cannot write the corpus " << outputPath << endl;
+    return 1;
+  }
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()
+                                            - start).count();
+  cerr << count << " deals (" << numResults[0] << " solved, " << numResults[1]
+       << " unsolvable, " << numResults[2] << " gave up) on "
+       << pool.NumThreads() << " threads in " << seconds << " s: "
+       << static_cast<uint64_t>(count / seconds) << " deals/s, "
+       << static_cast<uint64_t>(totalNodes / seconds) << " nodes/s" << endl;
+  return 0;
+}
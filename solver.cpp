@@ -0,0 +1,323 @@
+/**
+ * @file solver.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Searches for a winning line of play from a Solitaire deal.
+ */
+#include <algorithm>
+#include "solver.h"
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  const uint64_t Solver::kDefaultMaxNodes;
+  const uint64_t Solver::kNoMaxNodes;
+
+  /**
+   * The number of nodes a solver of a team visits between adding them to the
+   * team's count and checking whether to stop.
+   */
+  static const uint64_t kTeamBatch = 1024;
+
+  Solver::Solver(uint64_t maxNodes, size_t tableMegabytes)
+    : maxNodes(maxNodes), nodes(0), tableMegabytes(tableMegabytes),
+      shuffle(false), random(0) { }
+
+  /**
+   * Returns true if the card can be built up on the foundation.
+   */
+  static inline bool CanGoHome(const PackedBoard& board, CardCode card) {
+    if (card % kNumRanks == 0) {
+      return true;
+    }
+    for (CardCode top : board.foundation) {
+      if (top + 1 == card) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  int PriorityOf(const PackedBoard& board, Move move) {
+    switch (move.type) {
+    case Move::Type::TALON_TO_FOUNDATION:
+    case Move::Type::TABLEAU_TO_FOUNDATION:
+      return 0;
+
+    case Move::Type::TABLEAU_TO_TABLEAU: {
+      int size = board.tableauSize[move.from];
+      int shown = board.tableauShown[move.from];
+      if (move.count < size - shown) { // splits a run
+        // the run can only lie on one of the two cards of the rank above
+        // and the other color, so moving it only trades which of them is
+        // covered; that is worth trying when the one uncovered can go to
+        // the foundation
+        CardCode uncovered = board.tableau[move.from][size - move.count - 1];
+        return CanGoHome(board, uncovered) ? 4 : -1;
+      }
+      if (shown > 0) {                 // turns over a card
+        return 1;
+      }
+      // moving a whole pile to an empty pile only swaps the two piles
+      return board.tableauSize[move.to] == 0 ? -1 : 2;
+    }
+    case Move::Type::TALON_TO_TABLEAU:
+      return 3;
+
+    case Move::Type::NEW_TALON:
+      return 5;
+
+    case Move::Type::FOUNDATION_TO_TABLEAU:
+      return 6;
+
+    default:
+      return -1;
+    }
+  }
+
+  template <int kDrawCount>
+  void Solver::Expand(Frame& frame, bool dealt) {
+    frame.next = 0;
+
+    // a safe move to the foundation is the only one worth trying
+    Move safe;
+    if (board.FindSafeMove(safe)
+        && (!dealt || safe.type == Move::Type::TALON_TO_FOUNDATION)) {
+      frame.moves.Clear();
+      frame.moves.PushBack(safe);
+      frame.order[0] = 0;
+      frame.numOrdered = 1;
+      return;
+    }
+
+    board.GenerateMacroMoves<kDrawCount>(frame.moves);
+
+    // counting sort by priority keeps the generated order within a priority
+    int priorities[kMaxMoves];
+    int starts[kNumPriorities + 1] = { };
+    for (int i = 0; i < frame.moves.Size(); i++) {
+      Move::Type type = frame.moves[i].type;
+      priorities[i] = dealt && type != Move::Type::TALON_TO_FOUNDATION
+        && type != Move::Type::TALON_TO_TABLEAU
+        ? -1 : PriorityOf(board, frame.moves[i]);
+      if (priorities[i] >= 0) {
+        starts[priorities[i] + 1]++;
+      }
+    }
+    for (int priority = 0; priority < kNumPriorities; priority++) {
+      starts[priority + 1] += starts[priority];
+    }
+    frame.numOrdered = starts[kNumPriorities];
+    SOLITAIRE_COUNT(PRUNED_MOVES, frame.moves.Size() - frame.numOrdered);
+    for (int i = 0; i < frame.moves.Size(); i++) {
+      if (priorities[i] >= 0) {
+        frame.order[starts[priorities[i]]++] = i;
+      }
+    }
+
+    // each priority's moves now end at its start; shuffle them in place
+    for (int priority = 0; shuffle && priority < kNumPriorities; priority++) {
+      int first = priority == 0 ? 0 : starts[priority - 1];
+      for (int i = starts[priority] - 1; i > first; i--) {
+        swap(frame.order[i], frame.order[first + random.Below(i - first + 1)]);
+      }
+    }
+  }
+
+  bool Solver::EnterPath(uint64_t hash) {
+    if (2 * (pathHashes.size() + 1) > onPath.size()) {
+      // put the hashes back in the order they were reached, so that they
+      // can still be taken off in reverse
+      onPath.assign(max(size_t(64), 2 * onPath.size()), 0);
+      vector<uint64_t> hashes;
+      hashes.swap(pathHashes);
+      for (uint64_t reached : hashes) {
+        EnterPath(reached);
+      }
+    }
+    size_t mask = onPath.size() - 1;
+    size_t i = hash & mask;
+    while (onPath[i] != 0) {
+      if (onPath[i] == hash) {
+        return false;
+      }
+      i = (i + 1) & mask;
+    }
+    onPath[i] = hash;
+    pathHashes.push_back(hash);
+    return true;
+  }
+
+  void Solver::LeavePath() {
+    uint64_t hash = pathHashes.back();
+    pathHashes.pop_back();
+    size_t mask = onPath.size() - 1;
+    size_t i = hash & mask;
+    while (onPath[i] != hash) {
+      i = (i + 1) & mask;
+    }
+    onPath[i] = 0;
+  }
+
+  Solver::Result Solver::Solve(const PackedBoard& deal) {
+    if (!table) {
+      table.reset(new TranspositionTable(tableMegabytes));
+    }
+    table->NewSearch();
+    shuffle = false;
+    return Search(deal, *table, nullptr);
+  }
+
+  Solver::Result Solver::SolveTogether(const PackedBoard& deal,
+                                       vector<Solver>& solvers,
+                                       ThreadPool& pool,
+                                       TranspositionTable& table,
+                                       vector<Move>& solution,
+                                       uint64_t& nodes) {
+    Team team;
+    team.stopping = false;
+    team.nodes = 0;
+    table.NewSearch();
+    uint64_t maxNodes = solvers[0].maxNodes;
+    vector<Result> results(solvers.size());
+    pool.ParallelFor(0, solvers.size(), [&](int, uint64_t i) {
+        // the first solver tries moves in the usual order, the others each
+        // in an order of their own
+        Solver& solver = solvers[i];
+        solver.maxNodes = maxNodes;
+        solver.shuffle = i > 0;
+        solver.random = SplitMix64(i);
+        results[i] = solver.Search(deal, table, &team);
+      });
+
+    // a solver stopped by the team reports giving up, and a solver that ran
+    // out of positions has skipped some that the others were still
+    // searching, so the deal is only proved unsolvable if all of them ran out
+    Result result = Result::UNSOLVABLE;
+    solution.clear();
+    nodes = 0;
+    for (size_t i = 0; i < solvers.size(); i++) {
+      nodes += solvers[i].nodes;
+      if (results[i] == Result::SOLVED && result != Result::SOLVED) {
+        result = Result::SOLVED;
+        solution = solvers[i].solution;
+      } else if (results[i] == Result::GAVE_UP
+                 && result == Result::UNSOLVABLE) {
+        result = Result::GAVE_UP;
+      }
+    }
+    return result;
+  }
+
+  Solver::Result Solver::Search(const PackedBoard& deal,
+                                TranspositionTable& table, Team* team) {
+    SOLITAIRE_TIME(SOLVE);
+    return WithDrawCount(deal.numOpenCards, [&](auto drawCount) {
+        return SearchFor<decltype(drawCount)::value>(deal, table, team);
+      });
+  }
+
+  template <int kDrawCount>
+  Solver::Result Solver::SearchFor(const PackedBoard& deal,
+                                   TranspositionTable& table, Team* team) {
+    path.clear();
+    solution.clear();
+    pathHashes.clear();
+    fill(onPath.begin(), onPath.end(), 0);
+    nodes = 1;
+    table.Insert(deal.ProofHash<kDrawCount>(), 0);
+    EnterPath(deal.ProofHash<kDrawCount>());
+    if (deal.CanAutoComplete()) {
+      PackedBoard(deal).AutoComplete(solution);
+      return Result::SOLVED;
+    }
+
+    // the stack keeps its frames between searches, so depth counts the live
+    // ones
+    size_t depth = 0;
+    if (stack.empty()) {
+      stack.emplace_back();
+    }
+    board = deal;
+    Expand<kDrawCount>(stack[0], false);
+    depth = 1;
+
+    while (depth > 0) {
+      Frame& frame = stack[depth - 1];
+      if (frame.next == frame.numOrdered) { // exhausted this position
+        depth--;
+        if (depth > 0) {
+          if (frame.played.move.type != Move::Type::NEW_TALON) {
+            LeavePath();
+          }
+          board.Undo(frame.played);
+          path.pop_back();
+        }
+        continue;
+      }
+
+      Move move = frame.moves[frame.order[frame.next++]];
+      UndoRecord played;
+      board.ApplyMove<kDrawCount>(move, played);
+      // dealing only moves the cursors, which the table may not tell apart,
+      // so the position it leads to is taken as part of the one before it;
+      // a position on the path is one the table forgot while searching it
+      bool dealt = move.type == Move::Type::NEW_TALON;
+      if (!dealt && (!table.Insert(board.ProofHash<kDrawCount>(), depth)
+                     || !EnterPath(board.ProofHash<kDrawCount>()))) {
+        SOLITAIRE_COUNT(TRANSPOSITION_HITS, 1);
+        board.Undo(played);
+        continue;
+      }
+      SOLITAIRE_COUNT(SEARCH_NODES, 1);
+      if (team == nullptr) {
+        if (++nodes > maxNodes) {
+          return Result::GAVE_UP;
+        }
+      } else if (++nodes % kTeamBatch == 0) {
+        if (team->nodes.fetch_add(kTeamBatch) + kTeamBatch > maxNodes) {
+          team->stopping = true;
+        }
+        if (team->stopping) {
+          return Result::GAVE_UP;
+        }
+      }
+
+      path.push_back(move);
+      if (board.CanAutoComplete()) {
+        // spell out the new talons dealt at once one by one
+        for (Move step : path) {
+          if (step.type == Move::Type::NEW_TALON) {
+            solution.insert(solution.end(), max(int(step.count), 1),
+                            { Move::Type::NEW_TALON, 0, 0, 0 });
+          } else {
+            solution.push_back(step);
+          }
+        }
+        // the rest plays itself
+        PackedBoard(board).AutoComplete(solution);
+        if (team != nullptr) {
+          team->stopping = true;
+        }
+        return Result::SOLVED;
+      }
+
+      if (depth == stack.size()) {
+        stack.emplace_back();
+      }
+      stack[depth].played = played;
+      Expand<kDrawCount>(stack[depth], dealt);
+      depth++;
+    }
+    return Result::UNSOLVABLE;
+  }
+
+  const vector<Move>& Solver::GetSolution() const {
+    return solution;
+  }
+
+  uint64_t Solver::GetNodes() const {
+    return nodes;
+  }
+}
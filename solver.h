@@ -0,0 +1,183 @@
+/**
+ * @file solver.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Searches for a winning line of play from a Solitaire deal.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "deal.h"
+#include "packed_board.h"
+#include "thread_pool.h"
+#include "transposition.h"
+
+namespace solitaire {
+  /**
+   * The number of ranks PriorityOf gives moves.
+   */
+  const int kNumPriorities = 7;
+
+  /**
+   * Ranks how promising a move is, lower first, or returns -1 if the move can
+   * never help. The solver tries moves in this order.
+   */
+  int PriorityOf(const PackedBoard& board, Move move);
+
+  /**
+   * Solver runs a depth-first search over every legal move of a deal, never
+   * visiting a position twice while the transposition table remembers it.
+   * Either it finds a winning line, or it runs out of positions, which proves
+   * the deal cannot be won, or it reaches its node budget and gives up.
+   * A position the table has forgotten is only searched again, so the
+   * results hold whatever the size of the table, though a table too small
+   * for a deal can make its search take far longer. The positions on the
+   * search path are also kept apart from the table, so that forgetting one
+   * of them never sends the search round a cycle back to it.
+   *
+   * The solver sees the face-down cards as well as the rest, so its results
+   * are those of a player who knows every card, as in Thoughtful Solitaire,
+   * though it still only moves the cards the rules let a player move.
+   */
+  class Solver {
+  public:
+    enum class Result { SOLVED, UNSOLVABLE, GAVE_UP };
+
+  private:
+    /**
+     * One position on the search path, the move that reached it and the moves
+     * left to try from it. The search plays and takes back moves on a single
+     * board rather than keeping a copy of each position.
+     */
+    struct Frame {
+      UndoRecord played;
+      MoveBuffer moves;
+      std::uint8_t order[kMaxMoves];
+      int numOrdered;
+      int next;
+    };
+
+    /**
+     * What the solvers searching one deal together share: whether to stop,
+     * and the nodes visited by all of them, added in batches.
+     */
+    struct Team {
+      std::atomic<bool> stopping;
+      std::atomic<std::uint64_t> nodes;
+    };
+
+    std::uint64_t maxNodes;
+    std::uint64_t nodes;
+    std::size_t tableMegabytes;
+    std::unique_ptr<TranspositionTable> table;
+    PackedBoard board;
+    std::vector<Frame> stack;
+    std::vector<Move> path;
+    std::vector<Move> solution;
+
+    /**
+     * The hashes of the positions on the search path, other than those right
+     * after dealt new talons, in the order they were reached, and as a set:
+     * an open-addressed table at most half full, in which 0 marks an empty
+     * slot. Taking them off in the reverse order they went on leaves every
+     * probe sequence whole.
+     */
+    std::vector<std::uint64_t> pathHashes;
+    std::vector<std::uint64_t> onPath;
+
+    /**
+     * Whether to try moves of the same priority in a random order, so that
+     * solvers of a team search different parts of the tree first.
+     */
+    bool shuffle;
+    SplitMix64 random;
+
+    /**
+     * Generates the moves of the frame's position, dealing new talons only
+     * as many at once as it takes to reach a card that can be played, and
+     * sorts them with the most promising first, dropping moves that can never
+     * help. Right after dealt new talons, only plays of the talon card are
+     * worth trying, since that is what they were dealt for.
+     */
+    template <int kDrawCount>
+    void Expand(Frame& frame, bool dealt);
+
+    /**
+     * Puts the position with the hash on the search path. Returns false if it
+     * is on the path already.
+     */
+    bool EnterPath(std::uint64_t hash);
+
+    /**
+     * Takes the position last put on the search path off it.
+     */
+    void LeavePath();
+
+    /**
+     * Searches for a win from the position, remembering positions in the
+     * table. A solver of a team stops when the team is told to, and tells it
+     * to when it finds a win or the team runs out of nodes.
+     */
+    Result Search(const PackedBoard& deal, TranspositionTable& table,
+                  Team* team);
+
+    /**
+     * Searches like Search with the board's methods for the deal's draw
+     * count, kDrawCount, or kAnyDrawCount for one they are not compiled for.
+     */
+    template <int kDrawCount>
+    Result SearchFor(const PackedBoard& deal, TranspositionTable& table,
+                     Team* team);
+
+  public:
+    /**
+     * The number of positions a search visits before giving up, by default.
+     */
+    static const std::uint64_t kDefaultMaxNodes = 5000000;
+
+    /**
+     * A node budget no search reaches, so that every search either solves
+     * its deal or proves it unsolvable.
+     */
+    static const std::uint64_t kNoMaxNodes = UINT64_MAX;
+
+    /**
+     * Creates a solver that gives up after visiting maxNodes positions and
+     * remembers positions in a table of tableMegabytes, made when it first
+     * solves a deal.
+     */
+    explicit Solver(std::uint64_t maxNodes = kDefaultMaxNodes,
+                    std::size_t tableMegabytes
+                    = TranspositionTable::kDefaultMegabytes);
+
+    /**
+     * Searches for a win from the position.
+     */
+    Result Solve(const PackedBoard& deal);
+
+    /**
+     * Searches for a win from the position with every solver at once, one on
+     * each thread of the pool, sharing the table. The team gives up after
+     * visiting the first solver's maxNodes positions between them. Fills in
+     * the winning moves of the first solver to find some and the positions
+     * the team visited.
+     */
+    static Result SolveTogether(const PackedBoard& deal,
+                                std::vector<Solver>& solvers, ThreadPool& pool,
+                                TranspositionTable& table,
+                                std::vector<Move>& solution,
+                                std::uint64_t& nodes);
+
+    /**
+     * Returns the winning moves found by the last search.
+     */
+    const std::vector<Move>& GetSolution() const;
+
+    /**
+     * Returns the number of positions visited by the last search.
+     */
+    std::uint64_t GetNodes() const;
+  };
+}
@@ -0,0 +1,147 @@
+/**
+ * @file stats.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Counters and timers of what the engine does, reported as JSON.
+ */
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <pthread.h>
+#include "stats.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * The names of the counters and phases in the report.
+   */
+  static const char* const kCounterNames[kNumCounters] = {
+    "moves_new_talon", "moves_talon_to_foundation",
+    "moves_tableau_to_foundation", "moves_talon_to_tableau",
+    "moves_foundation_to_tableau", "moves_tableau_to_tableau",
+    "valid_moves_calls", "talon_cycles", "allocations", "search_nodes",
+    "transposition_hits", "pruned_moves"
+  };
+  static const char* const kPhaseNames[kNumPhases] = {
+    "render", "command", "play_game", "solve", "hint_search", "replay"
+  };
+
+  /**
+   * The most threads that count at once. Blocks are never freed, only handed
+   * to the next new thread, so none of the counts are lost when a thread
+   * ends. Threads beyond these share the last block and may lose counts.
+   */
+  static const int kMaxStatsThreads = 256;
+  static StatsBlock blocks[kMaxStatsThreads];
+
+  /**
+   * Gives the thread's block back when the thread ends.
+   */
+  struct StatsRelease {
+    ~StatsRelease() {
+      if (threadStats != &blocks[kMaxStatsThreads - 1]) {
+        threadStats->inUse.store(false, memory_order_release);
+      }
+    }
+  };
+
+  StatsBlock* RegisterStatsThread() {
+    // set the block before anything that could allocate and so count
+    threadStats = &blocks[kMaxStatsThreads - 1];
+    for (int i = 0; i < kMaxStatsThreads - 1; i++) {
+      bool free = false;
+      if (blocks[i].inUse.compare_exchange_strong(free, true,
+                                                  memory_order_acquire)) {
+        threadStats = &blocks[i];
+        break;
+      }
+    }
+    thread_local StatsRelease release;
+    return threadStats;
+  }
+
+  void WriteStats(ostream& out) {
+#ifdef SOLITAIRE_STATS
+    uint64_t counts[kNumCounters] = { };
+    uint64_t calls[kNumPhases] = { };
+    uint64_t nanoseconds[kNumPhases] = { };
+    for (const StatsBlock& block : blocks) {
+      for (int i = 0; i < kNumCounters; i++) {
+        counts[i] += block.counts[i].load(memory_order_relaxed);
+      }
+      for (int i = 0; i < kNumPhases; i++) {
+        calls[i] += block.phaseCalls[i].load(memory_order_relaxed);
+        nanoseconds[i] += block.phaseNanoseconds[i].load(memory_order_relaxed);
+      }
+    }
+
+    out << "{\"enabled\": true, \"counters\": {";
+    for (int i = 0; i < kNumCounters; i++) {
+      out << (i == 0 ? "" : ", ") << "\"" << kCounterNames[i] << "\": "
+          << counts[i];
+    }
+    out << "}, \"timers\": {";
+    for (int i = 0; i < kNumPhases; i++) {
+      out << (i == 0 ? "" : ", ") << "\"" << kPhaseNames[i]
+          << "\": {\"calls\": " << calls[i] << ", \"seconds\": "
+          << nanoseconds[i] / 1e9 << "}";
+    }
+    out << "}}" << endl;
+#else
+    out << "{\"enabled\": false}" << endl;
+#endif
+  }
+
+  StatsReport::StatsReport(bool enabled) : enabled(enabled), stopping(false) {
+    if (!enabled) {
+      return;
+    }
+    // threads created from now on inherit the mask, so only Run takes it
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    thread = std::thread(&StatsReport::Run, this);
+  }
+
+  StatsReport::~StatsReport() {
+    if (!enabled) {
+      return;
+    }
+    stopping = true;
+    pthread_kill(thread.native_handle(), SIGUSR1);
+    thread.join();
+    WriteStats(cerr);
+  }
+
+  void StatsReport::Run() {
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGUSR1);
+    int signal;
+    while (sigwait(&signals, &signal) == 0 && !stopping) {
+      WriteStats(cerr);
+    }
+  }
+}
+
+#ifdef SOLITAIRE_STATS
+void* operator new(size_t size) {
+  SOLITAIRE_COUNT(ALLOCATIONS, 1);
+  void* p = malloc(size == 0 ? 1 : size);
+  if (p == nullptr) {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept {
+  free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+  free(p);
+}
+#endif
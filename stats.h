@@ -0,0 +1,144 @@
+/**
+ * @file stats.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Counters and timers of what the engine does, reported as JSON.
+ */
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <thread>
+
+namespace solitaire {
+  /**
+   * The events counted. The first six are the moves Board plays, in the
+   * order of Move::Type.
+   */
+  enum class Counter { NEW_TALON, TALON_TO_FOUNDATION, TABLEAU_TO_FOUNDATION,
+      TALON_TO_TABLEAU, FOUNDATION_TO_TABLEAU, TABLEAU_TO_TABLEAU,
+      VALID_MOVES_CALLS, TALON_CYCLES, ALLOCATIONS, SEARCH_NODES,
+      TRANSPOSITION_HITS, PRUNED_MOVES };
+  const int kNumCounters = 12;
+
+  /**
+   * The phases timed.
+   */
+  enum class Phase { RENDER, COMMAND, PLAY_GAME, SOLVE, HINT_SEARCH, REPLAY };
+  const int kNumPhases = 6;
+
+  /**
+   * The counts of one thread. Only the thread itself writes them, so adding
+   * to one is a plain load and store, but any thread may read them.
+   */
+  struct StatsBlock {
+    std::atomic<std::uint64_t> counts[kNumCounters];
+    std::atomic<std::uint64_t> phaseCalls[kNumPhases];
+    std::atomic<std::uint64_t> phaseNanoseconds[kNumPhases];
+    std::atomic<bool> inUse;
+  };
+
+  /**
+   * The block of the calling thread, or nullptr before it first counts.
+   */
+  inline thread_local StatsBlock* threadStats = nullptr;
+
+  /**
+   * Gives the calling thread a block, one left by a thread that has ended if
+   * there is one, and returns it.
+   */
+  StatsBlock* RegisterStatsThread();
+
+  /**
+   * Adds to a count of the calling thread.
+   */
+  inline void AddStat(std::atomic<std::uint64_t>& count, std::uint64_t n) {
+    count.store(count.load(std::memory_order_relaxed) + n,
+                std::memory_order_relaxed);
+  }
+
+  inline StatsBlock& ThreadStats() {
+    return threadStats != nullptr ? *threadStats : *RegisterStatsThread();
+  }
+
+  /**
+   * ScopedTimer adds the time from its creation to its destruction, and one
+   * call, to a phase.
+   */
+  class ScopedTimer {
+  private:
+    Phase phase;
+    std::chrono::steady_clock::time_point start;
+
+  public:
+    explicit ScopedTimer(Phase phase)
+      : phase(phase), start(std::chrono::steady_clock::now()) { }
+
+    ~ScopedTimer() {
+      StatsBlock& block = ThreadStats();
+      int i = static_cast<int>(phase);
+      AddStat(block.phaseCalls[i], 1);
+      AddStat(block.phaseNanoseconds[i],
+              std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  std::chrono::steady_clock::now() - start).count());
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+  };
+
+  /**
+   * Writes the counts and timers of every thread so far as one line of JSON.
+   * Without SOLITAIRE_STATS the report only says that nothing was counted.
+   */
+  void WriteStats(std::ostream& out);
+
+  /**
+   * StatsReport writes the stats to stderr when it is destroyed and each
+   * time the process gets SIGUSR1, from a thread of its own that waits for
+   * the signal. Create it before any other thread, so that they all leave
+   * SIGUSR1 to that thread.
+   */
+  class StatsReport {
+  private:
+    bool enabled;
+    std::atomic<bool> stopping;
+    std::thread thread;
+
+    /**
+     * Waits for SIGUSR1 and writes the stats, until stopped.
+     */
+    void Run();
+
+  public:
+    /**
+     * Starts waiting for SIGUSR1 if enabled; otherwise does nothing.
+     */
+    explicit StatsReport(bool enabled);
+    ~StatsReport();
+
+    StatsReport(const StatsReport&) = delete;
+    StatsReport& operator=(const StatsReport&) = delete;
+  };
+}
+
+// build with "make DEFINES=-DSOLITAIRE_STATS" to count; otherwise the macros
+// compile to nothing
+#ifdef SOLITAIRE_STATS
+#define SOLITAIRE_COUNT(counter, n)                                     \
+  ::solitaire::AddStat(::solitaire::ThreadStats().counts[               \
+      static_cast<int>(::solitaire::Counter::counter)], (n))
+#define SOLITAIRE_COUNT_MOVE(type, n)                                   \
+  ::solitaire::AddStat(::solitaire::ThreadStats().counts[               \
+      static_cast<int>(type)], (n))
+#define SOLITAIRE_TIMER_NAME2(line) solitaireTimer##line
+#define SOLITAIRE_TIMER_NAME(line) SOLITAIRE_TIMER_NAME2(line)
+#define SOLITAIRE_TIME(phase)                                           \
+  ::solitaire::ScopedTimer SOLITAIRE_TIMER_NAME(__LINE__)(              \
+      ::solitaire::Phase::phase)
+#else
+#define SOLITAIRE_COUNT(counter, n) ((void) 0)
+#define SOLITAIRE_COUNT_MOVE(type, n) ((void) 0)
+#define SOLITAIRE_TIME(phase) ((void) 0)
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file tally.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Win rate statistics over ranges of deals, and their checkpoints.
+ */
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+#include "tally.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * The first line of a checkpoint file.
+   */
+  static const char kCheckpointMagic[] = "solitaire-winrate-checkpoint";
+  static const int kCheckpointVersion = 1;
+
+  /**
+   * The draw count of each tally of a run.
+   */
+  static const int kTallyDrawCounts[2] = { 1, 3 };
+
+  int EffortBucketOf(uint64_t nodes) {
+    int bucket = 0;
+    while (nodes >>= 1) {
+      bucket++;
+    }
+    return bucket;
+  }
+
+  void WinTally::Add(Solver::Result result, uint64_t nodes) {
+    int i = static_cast<int>(result);
+    numResults[i]++;
+    totalNodes += nodes;
+    effort[i][EffortBucketOf(nodes)]++;
+  }
+
+  uint64_t WinTally::NumDeals() const {
+    return numResults[0] + numResults[1] + numResults[2];
+  }
+
+  Interval WilsonInterval(uint64_t successes, uint64_t trials, double z) {
+    if (trials == 0) {
+      return { 0, 1 };
+    }
+    double n = trials;
+    double p = successes / n;
+    double z2 = z * z;
+    double center = (p + z2 / (2 * n)) / (1 + z2 / n);
+    double half = z * sqrt(p * (1 - p) / n + z2 / (4 * n * n)) / (1 + z2 / n);
+    return { max(0.0, center - half), min(1.0, center + half) };
+  }
+
+  bool WinRateRun::SameSettings(const WinRateRun& other) const {
+    return first == other.first && count == other.count
+      && maxNodes == other.maxNodes;
+  }
+
+  bool SaveCheckpoint(const string& path, const WinRateRun& run) {
+    string temporary = path + ".tmp";
+    FILE* file = fopen(temporary.c_str(), "w");
+    if (file == nullptr) {
+      return false;
+    }
+    fprintf(file, "%s %d\n", kCheckpointMagic, kCheckpointVersion);
+    fprintf(file, "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 "\n",
+            run.first, run.count, run.maxNodes, run.done);
+    for (int t = 0; t < 2; t++) {
+      const WinTally& tally = run.tallies[t];
+      fprintf(file, "draw %d %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64
+              "\n", kTallyDrawCounts[t], tally.numResults[0],
+              tally.numResults[1], tally.numResults[2], tally.totalNodes);
+      for (int r = 0; r < 3; r++) {
+        for (int k = 0; k < kNumEffortBuckets; k++) {
+          fprintf(file, k == 0 ? "%" PRIu64 : " %" PRIu64, tally.effort[r][k]);
+        }
+        fprintf(file, "\n");
+      }
+    }
+
+    // the data must reach the disk before the rename makes it the checkpoint
+    bool failed = fflush(file) != 0 || ferror(file) || fsync(fileno(file)) != 0;
+    if (fclose(file) != 0 || failed
+        || rename(temporary.c_str(), path.c_str()) != 0) {
+      remove(temporary.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  bool LoadCheckpoint(const string& path, WinRateRun& run) {
+    FILE* file = fopen(path.c_str(), "r");
+    if (file == nullptr) {
+      return false;
+    }
+    char magic[sizeof(kCheckpointMagic)] = { };
+    int version = 0;
+    bool ok = fscanf(file, "%28s %d", magic, &version) == 2
+      && strcmp(magic, kCheckpointMagic) == 0
+      && version == kCheckpointVersion
+      && fscanf(file, "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64,
+                &run.first, &run.count, &run.maxNodes, &run.done) == 4;
+    for (int t = 0; ok && t < 2; t++) {
+      WinTally& tally = run.tallies[t];
+      int drawCount = 0;
+      ok = fscanf(file, " draw %d %" SCNu64 " %" SCNu64 " %" SCNu64 " %"
+                  SCNu64, &drawCount, &tally.numResults[0],
+                  &tally.numResults[1], &tally.numResults[2],
+                  &tally.totalNodes) == 5
+        && drawCount == kTallyDrawCounts[t];
+      for (int r = 0; ok && r < 3; r++) {
+        for (int k = 0; ok && k < kNumEffortBuckets; k++) {
+          ok = fscanf(file, "%" SCNu64, &tally.effort[r][k]) == 1;
+        }
+      }
+      ok = ok && tally.NumDeals() == run.done;
+    }
+    fclose(file);
+    return ok && run.done <= run.count;
+  }
+}
@@ -0,0 +1,108 @@
+/**
+ * @file tally.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Win rate statistics over ranges of deals, and their checkpoints.
+ */
+#pragma once
+#include <cstdint>
+#include <string>
+#include "solver.h"
+
+namespace solitaire {
+  /**
+   * The number of buckets of the effort histogram. Bucket k counts the deals
+   * whose search visited from 2^k up to but not including 2^(k+1) positions.
+   */
+  const int kNumEffortBuckets = 64;
+
+  /**
+   * Returns the effort histogram bucket of a search that visited the number
+   * of positions.
+   */
+  int EffortBucketOf(std::uint64_t nodes);
+
+  /**
+   * WinTally adds up the solver's results over many deals of one draw count.
+   * It holds only counts, so the tally of a range of deals is the same
+   * whatever order the deals are added in.
+   */
+  struct WinTally {
+    std::uint64_t numResults[3];
+    std::uint64_t totalNodes;
+
+    /**
+     * The effort histogram of each Solver::Result.
+     */
+    std::uint64_t effort[3][kNumEffortBuckets];
+
+    /**
+     * Adds the result of one deal.
+     */
+    void Add(Solver::Result result, std::uint64_t nodes);
+
+    /**
+     * Returns the number of deals added.
+     */
+    std::uint64_t NumDeals() const;
+  };
+
+  /**
+   * A two-sided confidence interval of a proportion.
+   */
+  struct Interval {
+    double low;
+    double high;
+  };
+
+  /**
+   * The normal quantile of a two-sided 95% confidence interval.
+   */
+  const double kZ95 = 1.959964;
+
+  /**
+   * Returns the Wilson score interval of the proportion of successes out of
+   * trials, at the confidence level of the normal quantile z. Unlike the
+   * plain normal interval, it stays inside [0, 1] and does not collapse when
+   * there are no successes or no failures.
+   */
+  Interval WilsonInterval(std::uint64_t successes, std::uint64_t trials,
+                          double z = kZ95);
+
+  /**
+   * WinRateRun is the state of a long run that solves the count deals
+   * numbered from first on at both draw counts: its settings, how many deals
+   * are done, and the tallies of those deals. Deals are done in order, so the
+   * deals done are always the numbers from first up to first + done.
+   */
+  struct WinRateRun {
+    std::uint64_t first;
+    std::uint64_t count;
+    std::uint64_t maxNodes;
+    std::uint64_t done;
+
+    /**
+     * The tallies of draw 1 and draw 3 games.
+     */
+    WinTally tallies[2];
+
+    /**
+     * Returns whether the other run solves the same deals the same way, so
+     * one can carry on where the other stopped.
+     */
+    bool SameSettings(const WinRateRun& other) const;
+  };
+
+  /**
+   * Writes the run to a checkpoint file. The file is written next to the
+   * path and then renamed over it, so a crash while writing leaves the last
+   * checkpoint whole. Returns false if the file cannot be written.
+   */
+  bool SaveCheckpoint(const std::string& path, const WinRateRun& run);
+
+  /**
+   * Reads a checkpoint file written by SaveCheckpoint. Returns false if the
+   * file cannot be read or is not a checkpoint.
+   */
+  bool LoadCheckpoint(const std::string& path, WinRateRun& run);
+}
@@ -0,0 +1,199 @@
+/**
+ * @file test.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Checks of the rules the engine and the tools rely on.
+ */
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "canonical.h"
+#include "notation.h"
+#include "packed_board.h"
+#include "protocol.h"
+
+using namespace std;
+using namespace solitaire;
+
+static int numChecks = 0;
+static int numFailed = 0;
+
+/**
+ * Counts a check, and reports it if it failed.
+ */
+static void Check(bool ok, const string& what) {
+  numChecks++;
+  if (!ok) {
+    numFailed++;
+    cerr << "FAILED: " << what << endl;
+  }
+}
+
+/**
+ * Returns the position in the notation.
+ */
+static string TextOf(const PackedBoard& board) {
+  char text[kMaxPositionTextSize];
+  return string(text, FormatPosition(board, text));
+}
+
+/**
+ * Returns the text with its one occurrence of from replaced by to.
+ */
+static string Replace(string text, const string& from, const string& to) {
+  size_t at = text.find(from);
+  Check(at != string::npos, "the test position holds " + from);
+  return at == string::npos ? text : text.replace(at, from.size(), to);
+}
+
+static void TestNotation() {
+  // deal 0 of draw 3 has 9s face up on Tc in pile 1 and Jd on Td 3s in pile 2
+  PackedBoard deal;
+  deal.Deal(uint64_t(0), 3);
+  string text = TextOf(deal);
+  PackedBoard board;
+  Check(ParsePosition(text, board) && board.Hash() == deal.Hash(),
+        "a dealt position reads back");
+
+  Check(!ParsePosition(Replace(text, "3 playing", "2 playing"), board),
+        "a draw of 2 is rejected");
+  Check(!ParsePosition(Replace(text, "3 playing", "0 playing"), board),
+        "a draw of 0 is rejected");
+  Check(ParsePosition(Replace(text, "3 playing", "1 playing"), board),
+        "a draw of 1 is read");
+
+  // the deck of deal 0 holds 24 cards, so a talon cursor of 24 is empty
+  Check(!ParsePosition(Replace(text, "3 playing 0 24", "3 playing 5 24"),
+                       board),
+        "an empty talon with the stock past the start is rejected");
+  Check(!ParsePosition(Replace(text, "3 playing 0 24", "3 playing 6 2"),
+                       board),
+        "a talon of more cards than the draw is rejected");
+  Check(!ParsePosition(Replace(text, "3 playing 0 24", "1 playing 6 4"),
+                       board),
+        "a talon of two cards in a draw-one game is rejected");
+  Check(ParsePosition(Replace(text, "3 playing 0 24", "3 playing 6 3"), board),
+        "a talon of one draw is read");
+
+  Check(!ParsePosition(Replace(text, ": Tc | 9s :", ": | Tc 9s :"), board),
+        "face-up cards of one color are rejected");
+  Check(!ParsePosition(Replace(text, ": Tc | 9s : Td 3s | Jd :",
+                               ": Td | 9s : 3s | Tc Jd :"), board),
+        "face-up cards going up are rejected");
+  Check(!ParsePosition(Replace(text, ": Tc | 9s : Td 3s | Jd :",
+                               ": Tc | 9s : | Td 3s Jd :"), board),
+        "face-up cards skipping ranks are rejected");
+  Check(ParsePosition(Replace(text, ": Tc | 9s : Td 3s | Jd :",
+                              ": | Td 9s : Tc 3s | Jd :"), board),
+        "a face-up run is read");
+}
+
+static void TestAutoComplete() {
+  PackedBoard board;
+  vector<Move> moves;
+  Check(ParsePosition("1 playing 0 0 : : Js Kh Kc Kd : | Qs : | Ks : : : : :",
+                      board)
+        && board.CanAutoComplete() && board.AutoComplete(moves)
+        && board.IsWon() && moves.size() == 2,
+        "a won position plays out");
+
+  // no game can reach Ks on Qs, and the notation cannot hold it, so put it
+  // there by hand: the queen can then never reach the foundation
+  Check(ParsePosition("1 playing 0 0 : : Js Kh Kc Kd : | Ks : | Qs : : : : :",
+                      board), "the stuck position reads");
+  board.tableau[0][1] = board.tableau[0][0];
+  board.tableau[0][0] = board.tableau[1][0];
+  board.tableauSize[0] = 2;
+  board.tableauSize[1] = 0;
+  board.ResetHashes();
+  moves.clear();
+  Check(board.CanAutoComplete() && !board.AutoComplete(moves),
+        "a position that cannot be played out stops");
+}
+
+static void TestCanonical() {
+  PackedBoard deal;
+  deal.Deal(uint64_t(0), 3);
+
+  // the same tableau over the same stock cards in another order is another
+  // deal, which plays differently
+  PackedBoard reordered = deal;
+  swap(reordered.deck[0], reordered.deck[1]);
+  reordered.ResetHashes();
+  Check(CanonicalHash(reordered) != CanonicalHash(deal),
+        "the canonical hash keys the order of the deck");
+
+  // trading two tableau piles changes nothing that plays
+  PackedBoard swapped = deal;
+  swap(swapped.tableau[2], swapped.tableau[5]);
+  swap(swapped.tableauSize[2], swapped.tableauSize[5]);
+  swap(swapped.tableauShown[2], swapped.tableauShown[5]);
+  swapped.ResetHashes();
+  PackedBoard a;
+  PackedBoard b;
+  Canonicalize(deal, a);
+  Canonicalize(swapped, b);
+  Check(CanonicalHash(swapped) == CanonicalHash(deal)
+        && memcmp(&a, &b, sizeof(a)) == 0,
+        "equivalent positions have the same canonical bytes");
+}
+
+static void TestMoves() {
+  ostringstream out;
+  Move corrupt = { static_cast<Move::Type>(9), 1, 2, 0 };
+  corrupt.Print(out);
+  Check(out.str() == "?9:1:2", "a move of no known type prints its fields");
+
+  // a macro move deals several new talons, whichever board plays it
+  Board board(0, 3);
+  PackedBoard packed;
+  packed.Deal(uint64_t(0), 3);
+  Move deal = { Move::Type::NEW_TALON, 0, 0, 3 };
+  Check(board.ApplyMove(deal) && packed.ApplyMove(deal)
+        && board.Hash() == packed.Hash(),
+        "a macro new talon deals as many talons on a board as packed");
+}
+
+/**
+ * Returns what the session writes for the command.
+ */
+static string Run(CommandSession& session, const string& command) {
+  ostringstream out;
+  session.Execute(command, out);
+  return out.str();
+}
+
+static void TestProtocol() {
+  CommandSession session(0, 3);
+  Check(Run(session, "new 0 2") == "error bad deal\n",
+        "new rejects a draw of 2");
+  Check(Run(session, "new 5 1") == "ok 5\n", "new deals a draw-one game");
+
+  // every card is face up in a draw-one game, so it is won whatever the text
+  // says its status is
+  Check(Run(session, "load 1 playing 0 0 : : Qs Qh Qc Qd : | Ks : | Kh : | Kc"
+            " : | Kd : : :") == "ok won\n",
+        "load works out the status of the position");
+  Check(Run(session, "complete") == "ok won\n"
+        && Run(session, "show")
+        == "ok 1 won 0 0 : : Ks Kh Kc Kd : : : : : : :\n",
+        "complete plays out a loaded position");
+  Check(Run(session, "load 3 won 0 24 : Ts 4d Ad 7c 2c 7s Qc 5h 7h Ac 9h 8h"
+            " 6c 4h 2d Js 9c 8s 3h 6s 9d 2s Th 7d : -- -- -- -- : | Ks : Tc"
+            " | 9s : Td 3s | Jd : Kd Qs 3c | Kh : 6h Ah Jh 3d | 4s : Qd 4c 2h"
+            " Jc As | 5s : 5c Kc 6d 8c 5d 8d | Qh") == "ok playing\n",
+        "load does not take a won status on trust");
+}
+
+int main() {
+  TestNotation();
+  TestAutoComplete();
+  TestCanonical();
+  TestMoves();
+  TestProtocol();
+  cout << numChecks << " checks, " << numFailed << " failed" << endl;
+  return numFailed == 0 ? 0 : 1;
+}
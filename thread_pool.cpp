@@ -0,0 +1,159 @@
+/**
+ * @file thread_pool.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A work-stealing pool of threads for running batches of deals.
+ */
+#include "thread_pool.h"
+
+namespace solitaire {
+  using namespace std;
+
+  ThreadPool::ThreadPool(int numThreads)
+    : body(nullptr),
+      generation(0),
+      remaining(0),
+      numBusy(0),
+      stopping(false),
+      numPushes(0) {
+    if (numThreads <= 0) {
+      numThreads = max(1u, thread::hardware_concurrency());
+    }
+    queues.reset(new Queue[numThreads]);
+    for (int i = 0; i < numThreads; i++) {
+      threads.emplace_back(&ThreadPool::Run, this, i);
+    }
+  }
+
+  ThreadPool::~ThreadPool() {
+    {
+      lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    started.notify_all();
+    for (thread& t : threads) {
+      t.join();
+    }
+  }
+
+  int ThreadPool::NumThreads() const {
+    return threads.size();
+  }
+
+  void ThreadPool::Push(int worker, Range range) {
+    {
+      lock_guard<std::mutex> lock(queues[worker].mutex);
+      queues[worker].ranges.push_back(range);
+    }
+    {
+      lock_guard<std::mutex> lock(idleMutex);
+      numPushes++;
+    }
+    queued.notify_all();
+  }
+
+  bool ThreadPool::Pop(int worker, Range& range) {
+    lock_guard<std::mutex> lock(queues[worker].mutex);
+    if (queues[worker].ranges.empty()) {
+      return false;
+    }
+    range = queues[worker].ranges.back();
+    queues[worker].ranges.pop_back();
+    return true;
+  }
+
+  bool ThreadPool::Steal(int worker, Range& range) {
+    int numThreads = NumThreads();
+    for (int i = 1; i < numThreads; i++) {
+      Queue& victim = queues[(worker + i) % numThreads];
+      lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.ranges.empty()) {
+        range = victim.ranges.front();
+        victim.ranges.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void ThreadPool::Work(int worker) {
+    while (remaining.load() > 0) {
+      uint64_t seenPushes;
+      {
+        lock_guard<std::mutex> lock(idleMutex);
+        seenPushes = numPushes;
+      }
+      Range range;
+      if (!Pop(worker, range) && !Steal(worker, range)) {
+        // nothing to steal until someone queues more, and the indices still
+        // running may queue none
+        unique_lock<std::mutex> lock(idleMutex);
+        queued.wait(lock, [&] {
+            return remaining.load() == 0 || numPushes != seenPushes;
+          });
+        continue;
+      }
+
+      // run the first index and queue the rest in halves, the biggest at the
+      // front where thieves look
+      while (range.last - range.first > 1) {
+        uint64_t middle = range.first + (range.last - range.first) / 2;
+        Push(worker, { middle, range.last });
+        range.last = middle;
+      }
+      (*body)(worker, range.first);
+      if (remaining.fetch_sub(1) == 1) {
+        // wake the idle workers to see that the range is done
+        { lock_guard<std::mutex> lock(idleMutex); }
+        queued.notify_all();
+      }
+    }
+  }
+
+  void ThreadPool::Run(int worker) {
+    uint64_t seen = 0;
+    while (true) {
+      {
+        unique_lock<std::mutex> lock(mutex);
+        started.wait(lock, [&] { return stopping || generation != seen; });
+        if (stopping) {
+          return;
+        }
+        seen = generation;
+      }
+
+      Work(worker);
+
+      lock_guard<std::mutex> lock(mutex);
+      if (--numBusy == 0) {
+        finished.notify_all();
+      }
+    }
+  }
+
+  void ThreadPool::ParallelFor(uint64_t first, uint64_t last,
+                               const Body& body) {
+    if (first >= last) {
+      return;
+    }
+
+    // give every worker an equal share to start with
+    unique_lock<std::mutex> lock(mutex);
+    uint64_t numThreads = NumThreads();
+    uint64_t count = last - first;
+    for (uint64_t i = 0; i < numThreads; i++) {
+      Range range = { first + count * i / numThreads,
+                      first + count * (i + 1) / numThreads };
+      if (range.first < range.last) {
+        Push(i, range);
+      }
+    }
+    this->body = &body;
+    remaining = count;
+    numBusy = numThreads;
+    generation++;
+    started.notify_all();
+    finished.wait(lock, [&] { return numBusy == 0; });
+    this->body = nullptr;
+  }
+}
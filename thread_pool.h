@@ -0,0 +1,124 @@
+/**
+ * @file thread_pool.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A work-stealing pool of threads for running batches of deals.
+ */
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace solitaire {
+  /**
+   * ThreadPool runs a loop body over a range of indices on a fixed set of
+   * worker threads. Each worker splits its share of the range in halves and
+   * works through it from one end; a worker that runs dry steals the biggest
+   * piece left on another worker's queue, so a few slow indices never leave
+   * the other threads idle.
+   */
+  class ThreadPool {
+  public:
+    /**
+     * The loop body: it is called with the number of the worker running it,
+     * from 0 to NumThreads() - 1, and the index to run.
+     */
+    typedef std::function<void(int, std::uint64_t)> Body;
+
+  private:
+    /**
+     * A half-open range of indices still to run.
+     */
+    struct Range {
+      std::uint64_t first;
+      std::uint64_t last;
+    };
+
+    /**
+     * The ranges queued on one worker. The owner takes from the back and
+     * thieves take from the front.
+     */
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Range> ranges;
+    };
+
+    std::vector<std::thread> threads;
+    std::unique_ptr<Queue[]> queues;
+
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    const Body* body;
+    std::uint64_t generation;
+    std::atomic<std::uint64_t> remaining;
+    int numBusy;
+    bool stopping;
+
+    /**
+     * Workers with nothing to run sleep on queued until another worker queues
+     * a range, which adds to numPushes, or the last index is done.
+     */
+    std::mutex idleMutex;
+    std::condition_variable queued;
+    std::uint64_t numPushes;
+
+    /**
+     * The loop each worker thread runs until the pool is destroyed.
+     */
+    void Run(int worker);
+
+    /**
+     * Runs indices on the worker until the whole range is done.
+     */
+    void Work(int worker);
+
+    /**
+     * Takes the last range queued on the worker.
+     */
+    bool Pop(int worker, Range& range);
+
+    /**
+     * Takes the first range queued on some other worker.
+     */
+    bool Steal(int worker, Range& range);
+
+    /**
+     * Queues a range on the worker.
+     */
+    void Push(int worker, Range range);
+
+  public:
+    /**
+     * Starts the given number of worker threads, or one per hardware thread
+     * if it is 0.
+     */
+    explicit ThreadPool(int numThreads = 0);
+
+    /**
+     * Stops and joins the worker threads.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * Returns the number of worker threads.
+     */
+    int NumThreads() const;
+
+    /**
+     * Calls body once for each index from first up to but not including last,
+     * and returns when all the calls have returned.
+     */
+    void ParallelFor(std::uint64_t first, std::uint64_t last,
+                     const Body& body);
+  };
+}
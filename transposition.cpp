@@ -0,0 +1,87 @@
+/**
+ * @file transposition.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A fixed-size table of searched positions that threads can share.
+ */
+#include <climits>
+#include "transposition.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * The data of a slot: the generation of the search that stored it in the
+   * low 16 bits, and its ply above them.
+   */
+  static inline uint64_t DataOf(uint16_t generation, int ply) {
+    return generation | uint64_t(ply) << 16;
+  }
+
+  static inline uint16_t GenerationOf(uint64_t data) {
+    return uint16_t(data);
+  }
+
+  static inline int PlyOf(uint64_t data) {
+    return int(data >> 16);
+  }
+
+  const size_t TranspositionTable::kDefaultMegabytes;
+
+  TranspositionTable::TranspositionTable(size_t megabytes) : generation(0) {
+    // a power of two number of buckets that fits in the memory budget
+    numBuckets = 1;
+    while (numBuckets * 2 * sizeof(Bucket) <= megabytes << 20) {
+      numBuckets *= 2;
+    }
+    buckets.reset(new Bucket[numBuckets]);
+    Clear();
+  }
+
+  void TranspositionTable::Clear() {
+    for (size_t i = 0; i < numBuckets; i++) {
+      for (Slot& slot : buckets[i].slots) {
+        slot.check.store(0, memory_order_relaxed);
+        slot.data.store(0, memory_order_relaxed);
+      }
+    }
+  }
+
+  void TranspositionTable::NewSearch() {
+    // slots of earlier generations are stale; clear them all only when the
+    // generation wraps around, since no search is of generation 0
+    if (++generation == 0) {
+      Clear();
+      generation = 1;
+    }
+  }
+
+  bool TranspositionTable::Insert(uint64_t hash, int ply) {
+    Bucket& bucket = buckets[hash & (numBuckets - 1)];
+    Slot* victim = nullptr;
+    int victimPly = -1;
+    for (Slot& slot : bucket.slots) {
+      uint64_t data = slot.data.load(memory_order_relaxed);
+      uint64_t check = slot.check.load(memory_order_relaxed);
+      int slotPly = INT_MAX; // an empty slot, or one of an earlier search
+      if (GenerationOf(data) == generation) {
+        if ((check ^ data) == hash) {
+          return false;
+        }
+        slotPly = PlyOf(data);
+      }
+      if (slotPly > victimPly) {
+        victim = &slot;
+        victimPly = slotPly;
+      }
+    }
+    uint64_t data = DataOf(generation, ply);
+    victim->data.store(data, memory_order_relaxed);
+    victim->check.store(hash ^ data, memory_order_relaxed);
+    return true;
+  }
+
+  size_t TranspositionTable::NumSlots() const {
+    return numBuckets * sizeof(Bucket::slots) / sizeof(Slot);
+  }
+}
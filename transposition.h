@@ -0,0 +1,78 @@
+/**
+ * @file transposition.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief A fixed-size table of searched positions that threads can share.
+ */
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+namespace solitaire {
+  /**
+   * TranspositionTable remembers which positions a search has reached, by
+   * hash, in a fixed amount of memory. When a bucket is full, a new position
+   * pushes out one left by an earlier search, or else the one farthest from
+   * the root, since that one is the cheapest to search again.
+   *
+   * Any number of threads may insert at once without locks. Each slot keeps
+   * its data and the hash xor the data in two words, so a slot torn by two
+   * threads writing it at once no longer matches any hash and reads as
+   * empty. A lost or torn slot only costs searching a position twice.
+   */
+  class TranspositionTable {
+  private:
+    struct Slot {
+      std::atomic<std::uint64_t> check;
+      std::atomic<std::uint64_t> data;
+    };
+
+    /**
+     * The slots a position may be stored in, which fill one cache line.
+     */
+    struct alignas(64) Bucket {
+      Slot slots[4];
+    };
+
+    std::unique_ptr<Bucket[]> buckets;
+    std::size_t numBuckets;
+    std::uint16_t generation;
+
+    /**
+     * Empties every slot.
+     */
+    void Clear();
+
+  public:
+    /**
+     * The memory of a table, by default.
+     */
+    static const std::size_t kDefaultMegabytes = 64;
+
+    /**
+     * Creates an empty table of at most the given megabytes.
+     */
+    explicit TranspositionTable(std::size_t megabytes = kDefaultMegabytes);
+
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+     * Starts a new search, so that every position inserted before counts as
+     * not reached. Must not be called while a thread is inserting.
+     */
+    void NewSearch();
+
+    /**
+     * Records that the search reached the position with the hash ply moves
+     * from the root. Returns false if it already had in this search.
+     */
+    bool Insert(std::uint64_t hash, int ply);
+
+    /**
+     * Returns the number of positions the table can hold.
+     */
+    std::size_t NumSlots() const;
+  };
+}
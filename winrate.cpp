@@ -0,0 +1,206 @@
+/**
+ * @file winrate.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Measures the win rates of draw 1 and draw 3 games over many deals.
+ */
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <unistd.h>
+#include <vector>
+#include "solitaire.h"
+#include "solver.h"
+#include "stats.h"
+#include "tally.h"
+#include "thread_pool.h"
+
+using namespace std;
+using namespace solitaire;
+
+static void PrintUsage(const char* program) {
+  cerr << "Usage: " << program << " [-n max-nodes] [-j threads]"
+       << " [-c checkpoint] [--stats] first count" << endl
+       << endl
+       << "Solves the count deals numbered from first on as draw 1 and draw 3"
+       << endl
+       << "games and prints the win rate of each with a 95% confidence" << endl
+       << "interval and a histogram of the positions searched per deal. With"
+       << endl
+       << "-c, saves the deals done and their tallies to the checkpoint file"
+       << endl
+       << "as it goes, and carries on from it if it already exists. With"
+       << endl
+       << "--stats, writes what the engine counted as JSON to stderr at exit"
+       << endl
+       << "and on SIGUSR1." << endl;
+}
+
+/**
+ * The draw count of each tally of a run.
+ */
+static const int kDrawCounts[2] = { kOneCardGame, kThreeCardGame };
+
+/**
+ * The number of deals solved between checkpoints. A run that is stopped
+ * loses at most the deals of one block, which are solved again on resuming.
+ */
+static const uint64_t kBlockSize = 1 << 10;
+
+/**
+ * Set by SIGINT or SIGTERM to stop after the block being solved.
+ */
+static volatile sig_atomic_t stopRequested = 0;
+
+static void RequestStop(int) {
+  stopRequested = 1;
+}
+
+/**
+ * Writes a proportion as a percentage.
+ */
+static void PrintPercent(double proportion) {
+  cout << fixed << setprecision(2) << 100 * proportion << "%";
+}
+
+/**
+ * Writes the results, the win rate and the effort histogram of a tally.
+ */
+static void PrintTally(int numOpenCards, const WinTally& tally) {
+  uint64_t deals = tally.NumDeals();
+  const uint64_t* results = tally.numResults;
+  cout << "draw " << numOpenCards << ": " << deals << " deals, " << results[0]
+       << " solved, " << results[1] << " unsolvable, " << results[2]
+       << " gave up, " << tally.totalNodes << " nodes" << endl;
+  if (deals == 0) {
+    return;
+  }
+
+  // deals the solver gave up on may or may not be winnable, so the win rate
+  // lies between counting them all as losses and all as wins
+  Interval low = WilsonInterval(results[0], deals);
+  Interval high = WilsonInterval(results[0] + results[2], deals);
+  cout << "  win rate ";
+  PrintPercent(double(results[0]) / deals);
+  if (results[2] > 0) {
+    cout << " to ";
+    PrintPercent(double(results[0] + results[2]) / deals);
+  }
+  cout << ", 95% confidence interval ";
+  PrintPercent(low.low);
+  cout << " to ";
+  PrintPercent(high.high);
+  cout << endl;
+
+  cout << "  nodes\tsolved\tunsolvable\tgave up" << endl;
+  for (int k = 0; k < kNumEffortBuckets; k++) {
+    if (tally.effort[0][k] + tally.effort[1][k] + tally.effort[2][k] == 0) {
+      continue;
+    }
+    cout << "  " << (k == 0 ? 0 : uint64_t(1) << k) << "+\t"
+         << tally.effort[0][k] << "\t" << tally.effort[1][k] << "\t"
+         << tally.effort[2][k] << endl;
+  }
+}
+
+int main(int argc, char* argv[]) {
+  WinRateRun run = { };
+  run.maxNodes = Solver::kDefaultMaxNodes;
+  int numThreads = 0;
+  const char* checkpointPath = nullptr;
+  bool stats = false;
+  int argi = 1;
+  for (/**/; argi < argc && argv[argi][0] == '-'; argi++) {
+    if (strcmp(argv[argi], "-n") == 0 && argi + 1 < argc) {
+      run.maxNodes = strtoull(argv[++argi], nullptr, 10);
+    } else if (strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+      numThreads = atoi(argv[++argi]);
+    } else if (strcmp(argv[argi], "-c") == 0 && argi + 1 < argc) {
+      checkpointPath = argv[++argi];
+    } else if (strcmp(argv[argi], "--stats") == 0) {
+      stats = true;
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (argi + 2 != argc) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+  run.first = strtoull(argv[argi], nullptr, 10);
+  run.count = strtoull(argv[argi + 1], nullptr, 10);
+
+  if (checkpointPath != nullptr) {
+    WinRateRun saved;
+    if (LoadCheckpoint(checkpointPath, saved)) {
+      if (!saved.SameSettings(run)) {
+        cerr << "The checkpoint " << checkpointPath << " is of deals "
+             << saved.first << " to " << saved.first + saved.count - 1
+             << " with -n " << saved.maxNodes << endl;
+        return 1;
+      }
+      run = saved;
+      cerr << "Resuming after " << run.done << " of " << run.count << " deals"
+           << endl;
+    } else if (access(checkpointPath, F_OK) == 0) {
+      cerr << "Cannot read the checkpoint " << checkpointPath << endl;
+      return 1;
+    }
+  }
+  signal(SIGINT, RequestStop);
+  signal(SIGTERM, RequestStop);
+
+  // each worker keeps its own position and search state; a block solves each
+  // of its deals once per draw count
+  StatsReport report(stats);
+  ThreadPool pool(numThreads);
+  vector<Solver> solvers;
+  for (int i = 0; i < pool.NumThreads(); i++) {
+    solvers.emplace_back(run.maxNodes);
+  }
+  vector<PackedBoard> boards(pool.NumThreads());
+  vector<Solver::Result> results(2 * kBlockSize);
+  vector<uint64_t> nodes(2 * kBlockSize);
+  uint64_t startDone = run.done;
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  while (run.done < run.count && !stopRequested) {
+    uint64_t blockFirst = run.done;
+    uint64_t blockSize = min(kBlockSize, run.count - blockFirst);
+    pool.ParallelFor(0, 2 * blockSize, [&](int worker, uint64_t i) {
+        boards[worker].Deal(run.first + blockFirst + i / 2,
+                            kDrawCounts[i % 2]);
+        results[i] = solvers[worker].Solve(boards[worker]);
+        nodes[i] = solvers[worker].GetNodes();
+      });
+
+    for (uint64_t i = 0; i < 2 * blockSize; i++) {
+      run.tallies[i % 2].Add(results[i], nodes[i]);
+    }
+    run.done += blockSize;
+    if (checkpointPath != nullptr && !SaveCheckpoint(checkpointPath, run)) {
+      cerr << "Cannot write the checkpoint " << checkpointPath << endl;
+      return 1;
+    }
+    cerr << "\r" << run.done << " of " << run.count << " deals" << flush;
+  }
+  cerr << endl;
+
+  double seconds = chrono::duration<double>(chrono::steady_clock::now()
+                                            - start).count();
+  for (int t = 0; t < 2; t++) {
+    PrintTally(kDrawCounts[t], run.tallies[t]);
+  }
+  cerr << run.done - startDone << " deals at both draw counts on "
+       << pool.NumThreads() << " threads in " << seconds << " s" << endl;
+  if (run.done < run.count) {
+    cerr << "Stopped after " << run.done << " of " << run.count << " deals"
+         << endl;
+    return 3;
+  }
+  return 0;
+}
@@ -0,0 +1,38 @@
+/**
+ * @file zobrist.cpp
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Random keys for hashing board positions one change at a time.
+ */
+#include "deal.h"
+#include "zobrist.h"
+
+namespace solitaire {
+  using namespace std;
+
+  /**
+   * Fills a table of keys with the next numbers of the sequence.
+   */
+  template <class Table>
+  static void Fill(Table& table, SplitMix64& random) {
+    uint64_t* keys = reinterpret_cast<uint64_t*>(&table);
+    for (size_t i = 0; i < sizeof(table) / sizeof(uint64_t); i++) {
+      keys[i] = random.Next();
+    }
+  }
+
+  ZobristKeys::ZobristKeys() {
+    SplitMix64 random(0x501174125eedULL);
+    Fill(tableau, random);
+    Fill(shown, random);
+    Fill(foundation, random);
+    Fill(deck, random);
+    Fill(stock, random);
+    Fill(talon, random);
+    Fill(on, random);
+    Fill(shownCard, random);
+    Fill(next, random);
+  }
+
+  const ZobristKeys kZobristKeys;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file zobrist.h
+ * @author David Xu
+ * @author Connie Yuan
+ * @brief Random keys for hashing board positions one change at a time.
+ */
+#pragma once
+#include <cassert>
+#include <cstdint>
+#include "packed_board.h"
+
+namespace solitaire {
+  /**
+   * ZobristKeys holds one random 64-bit key for each fact about a position. A
+   * position's hash is the XOR of the keys of the facts that hold in it, so a
+   * move updates the hash by XORing out the facts it ends and XORing in the
+   * ones it starts.
+   *
+   * The stock and talon are hashed as the set of cards left in the deck plus
+   * the card before each cursor. The deck never changes order during a game,
+   * so this pins down the cursors without hashing every card's index, which
+   * shifts whenever a talon card is played. Positions of two deals whose decks
+   * hold the same cards in another order can share a hash, so the canonical
+   * hash, which compares positions across deals, also keys each deck card by
+   * the card after it.
+   *
+   * The symmetric hash keys the tableau by which card lies on which and which
+   * card is the first face up, and the foundation by suit, so it does not
+   * change when the tableau or foundation piles trade places.
+   */
+  struct ZobristKeys {
+    /**
+     * A card at an index of a tableau pile.
+     */
+    std::uint64_t tableau[kTableauSize][kMaxTableauPileSize][kDeckSize];
+
+    /**
+     * The index of the first face-up card of a tableau pile.
+     */
+    std::uint64_t shown[kTableauSize][kMaxTableauPileSize];
+
+    /**
+     * The top card of a foundation pile, with kDeckSize for an empty pile.
+     */
+    std::uint64_t foundation[kNumSuits][kDeckSize + 1];
+
+    /**
+     * A card in the stock or talon.
+     */
+    std::uint64_t deck[kDeckSize];
+
+    /**
+     * The accessible talon card, with kDeckSize when the talon is empty.
+     */
+    std::uint64_t stock[kDeckSize + 1];
+
+    /**
+     * The first talon card on display, with kDeckSize when there is none.
+     */
+    std::uint64_t talon[kDeckSize + 1];
+
+    /**
+     * For the symmetric hash, a card of the tableau lying on another card,
+     * with kDeckSize for a card at the bottom of its pile.
+     */
+    std::uint64_t on[kDeckSize][kDeckSize + 1];
+
+    /**
+     * For the symmetric hash, the first face-up card of a tableau pile.
+     */
+    std::uint64_t shownCard[kDeckSize];
+
+    /**
+     * For the canonical hash, a card of the deck followed by another, with
+     * kDeckSize for the last card.
+     */
+    std::uint64_t next[kDeckSize][kDeckSize + 1];
+
+    /**
+     * Fills the tables from a fixed seed, so hashes are the same in every run.
+     */
+    ZobristKeys();
+  };
+
+  extern const ZobristKeys kZobristKeys;
+
+  /**
+   * Returns the index of a card in the tables that allow an empty slot.
+   */
+  inline int SlotOf(CardCode card) {
+    return card == kNoCard ? kDeckSize : card;
+  }
+
+  inline std::uint64_t TableauKey(int pile, int index, CardCode card) {
+    return kZobristKeys.tableau[pile][index][card];
+  }
+
+  inline std::uint64_t ShownKey(int pile, int index) {
+    return kZobristKeys.shown[pile][index];
+  }
+
+  inline std::uint64_t FoundationKey(int pile, CardCode top) {
+    return kZobristKeys.foundation[pile][SlotOf(top)];
+  }
+
+  /**
+   * Returns the symmetric hash key of a card of the tableau lying on another
+   * card, or on nothing if below is kNoCard.
+   */
+  inline std::uint64_t OnKey(CardCode card, CardCode below) {
+    return kZobristKeys.on[card][SlotOf(below)];
+  }
+
+  inline std::uint64_t ShownCardKey(CardCode card) {
+    return kZobristKeys.shownCard[card];
+  }
+
+  /**
+   * Returns the canonical hash key of a deck card followed by another, or by
+   * nothing if next is kNoCard.
+   */
+  inline std::uint64_t NextKey(CardCode card, CardCode next) {
+    return kZobristKeys.next[card][SlotOf(next)];
+  }
+
+  /**
+   * Returns the symmetric hash key of a foundation pile's top card, which is
+   * keyed by its suit rather than the pile it is on. An empty pile has none.
+   */
+  inline std::uint64_t SuitTopKey(CardCode top) {
+    return top == kNoCard ? 0 : kZobristKeys.foundation[top / kNumRanks][top];
+  }
+
+  inline std::uint64_t DeckKey(CardCode card) {
+    return kZobristKeys.deck[card];
+  }
+
+  /**
+   * Returns the key of the stock and talon cursors, given the accessible talon
+   * card and the first talon card on display.
+   */
+  inline std::uint64_t CursorKey(CardCode talonCard, CardCode talonFirst) {
+    return kZobristKeys.stock[SlotOf(talonCard)]
+      ^ kZobristKeys.talon[SlotOf(talonFirst)];
+  }
+
+  /**
+   * HashCheck checks, when it goes out of scope, that a position's hash kept
+   * move by move matches one computed from scratch. It only does so in builds
+   * with SOLITAIRE_DEBUG_HASH defined and costs nothing otherwise.
+   */
+  template <class Position>
+  class HashCheck {
+#ifdef SOLITAIRE_DEBUG_HASH
+  private:
+    const Position& position;
+
+  public:
+    explicit HashCheck(const Position& position) : position(position) { }
+
+    ~HashCheck() {
+      assert(position.Hash() == position.ComputeHash());
+    }
+#else
+  public:
+    explicit HashCheck(const Position&) { }
+#endif
+  };
+}